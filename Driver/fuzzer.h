@@ -7,15 +7,75 @@ extern "C" {
   // Harness types
   typedef enum {
     HARNESS_BYTES = 0,
-    HARNESS_STRING = 1
+    HARNESS_STRING = 1,
+    HARNESS_GRAMMAR = 2   // Byte target, inputs derived from a grammar (needs PEELFUZZ_GRAMMAR build)
   } HarnessType;
 
+  // Grammar production; expansion references nonterminals as {NAME}
+  typedef struct {
+    const char* nonterm;
+    const char* expansion;
+  } GrammarRule;
+
   // Scheduler types
   typedef enum {
     SCHEDULER_QUEUE = 0,
-    SCHEDULER_WEIGHTED = 1
+    SCHEDULER_WEIGHTED = 1,
+    SCHEDULER_MINIMIZED = 2,  // Queue over favored entries (smallest len × exec time per edge)
+
+    // AFLFast power schedules (weighted scheduler + power-aware mutational stage)
+    SCHEDULER_FAST      = 3,
+    SCHEDULER_EXPLORE   = 4,
+    SCHEDULER_EXPLOIT   = 5,
+    SCHEDULER_COE       = 6,
+    SCHEDULER_LIN       = 7,
+    SCHEDULER_QUAD      = 8
   } SchedulerType;
 
+  // Mutation operator scheduling
+  typedef enum {
+    MUTATOR_HAVOC = 0,   // Uniformly random havoc operators
+    MUTATOR_MOPT  = 1    // MOpt: operators re-weighted by the coverage they find
+  } MutatorType;
+
+  // What the campaign searches for
+  typedef enum {
+    FUZZ_COVERAGE = 0,   // New coverage; crashes are objectives, hangs go to hang_dir
+    FUZZ_PERF     = 1    // PerfFuzz: maximize per-edge hit counts, report runs over budget
+  } FuzzMode;
+
+  // How custom mutator callbacks combine with havoc
+  typedef enum {
+    CUSTOM_MUTATOR_ALONGSIDE = 0,  // Extra stage after havoc
+    CUSTOM_MUTATOR_EXCLUSIVE = 1   // Replace havoc entirely
+  } CustomMutatorMode;
+
+  // Same signatures as LLVMFuzzerCustomMutator / LLVMFuzzerCustomCrossOver
+  typedef size_t (*CustomMutatorFn)(uint8_t* data, size_t size, size_t max_size, unsigned int seed);
+  typedef size_t (*CustomCrossOverFn)(const uint8_t* data1, size_t size1,
+                                      const uint8_t* data2, size_t size2,
+                                      uint8_t* out, size_t max_out_size, unsigned int seed);
+
+  // Repairs checksums / length fields in place before an input runs or is saved
+  typedef void (*FixupFn)(uint8_t* buf, size_t len);
+
+  // Campaign counters, aggregated over all cores
+  typedef struct {
+    uint64_t executions;
+    double   execs_per_sec;
+    uint64_t corpus_count;
+    uint64_t objective_count;
+    uint64_t edges_hit;
+    uint64_t edges_total;
+    uint64_t run_time_sec;
+    uint32_t clients;
+    uint32_t running;       // 1 until the campaign has exited
+    double   map_density;   // Percent of coverage map entries hit
+  } PeelFuzzStats;
+
+  // Receives aggregate stats; ctx is the stats_cb_ctx from the config
+  typedef void (*StatsFn)(const PeelFuzzStats* stats, void* ctx);
+
   // Full configuration structure
   typedef struct {
     HarnessType     harness_type;
@@ -26,10 +86,54 @@ extern "C" {
     const char*     crash_dir;       // NULL = "./crashes"
     uint32_t        seed_count;      // 0 = default (8)
     uint32_t        core_count;      // 0 = auto-detect (all available cores)
+    const char*     hang_dir;        // NULL = "./hangs"
+    uint32_t        trim_pct;        // % of time spent trimming corpus entries, 0 = disabled
+    MutatorType     mutator_type;    // 0 = MUTATOR_HAVOC
+    const char*     strategy_plan;   // Per-core strategies, e.g. "0=explore,1-3=queue+mopt". NULL = uniform
+    CustomMutatorFn   custom_mutator_fn;    // NULL = none
+    CustomCrossOverFn custom_crossover_fn;  // NULL = none
+    CustomMutatorMode custom_mutator_mode;  // 0 = CUSTOM_MUTATOR_ALONGSIDE
+    FixupFn           fixup_fn;             // NULL = none
+    uint32_t          checksum_repair;      // 1 = auto-detect and repair checksums (needs trace-cmp), 0 = disabled
+    const char*        grammar_file;        // HARNESS_GRAMMAR: JSON rule list. NULL = use grammar_rules
+    const GrammarRule* grammar_rules;       // HARNESS_GRAMMAR: inline rules, first one is the start symbol
+    uint32_t           grammar_rule_count;
+    uint32_t           max_input_len;       // 0 = default (1 MiB)
+    uint32_t           len_control;         // libFuzzer -len_control style cap growth, 0 = disabled (e.g. 100)
+    uint32_t           input_cache_slots;   // Recent-input hash cache size, 0 = disabled (65536 for HARNESS_STRING)
+    uint32_t           stop_after_objectives; // Stop all cores after N objectives (1 = first crash), 0 = never
+    uint32_t           stop_plateau_sec;    // Stop all cores after N seconds without new edges, 0 = never
+    const char*        stats_dir;           // fuzzer_stats + plot_data directory, NULL = disabled
+    uint32_t           stats_interval_sec;  // Seconds between stats file updates, 0 = default (5)
+    uint32_t           monitor_interval_sec; // One aggregate status line per N seconds, 0 = a line per client event
+    uint32_t           monitor_per_client;  // 1 = add per-client lines to each summary, 0 = aggregate only
+    uint16_t           metrics_port;        // OpenMetrics endpoint on 127.0.0.1, 0 = disabled
+    StatsFn            stats_cb;            // Aggregate stats callback, NULL = none
+    void*              stats_cb_ctx;        // Passed back to stats_cb
+    uint32_t           stats_cb_interval_ms; // Min ms between stats_cb calls, 0 = as often as possible (250 ms with std)
+    const char*        slow_dir;            // NULL = "./slow"
+    uint32_t           slow_input_count;    // Keep the N slowest corpus entries in slow_dir, 0 = disabled
+    FuzzMode           fuzz_mode;           // 0 = FUZZ_COVERAGE
+    uint64_t           perf_hit_budget;     // FUZZ_PERF: runs with more edge hits are objectives, 0 = no budget
+    const char*        perf_dir;            // NULL = "./perf"
+    uint64_t           latency_budget_us;   // Inputs confirmed slower than this are objectives, 0 = disabled
+    const char*        slow_inputs_dir;     // NULL = "./slow_inputs"
   } PeelFuzzConfig;
 
   // Main fuzzing entry point
   void peel_fuzz_run(const PeelFuzzConfig* config);
+  // Background campaign handle (std builds only)
+  typedef struct PeelFuzzSession PeelFuzzSession;
+
+  // Fork the campaign into the background. NULL on failure.
+  // Forks without exec: call it only while the process is single-threaded
+  PeelFuzzSession* peel_fuzz_start(const PeelFuzzConfig* config);
+  // Lock-free snapshot of the campaign counters
+  void peel_fuzz_stats(PeelFuzzSession* session, PeelFuzzStats* out);
+  // Ask all cores to stop; returns immediately
+  void peel_fuzz_stop(PeelFuzzSession* session);
+  // Wait for the campaign to exit and free the handle. Returns its exit code
+  int  peel_fuzz_join(PeelFuzzSession* session);
 }
 
 enum class FuzzDuration : uint64_t {
@@ -49,6 +153,57 @@ enum class FuzzDuration : uint64_t {
   TwentyFourHr  = OneHr   * 24,
 };
 
+// RAII wrapper around a background campaign: stops and joins on destruction
+class FuzzSession {
+  private:
+    PeelFuzzSession* m_session;
+
+  public:
+    explicit FuzzSession(const PeelFuzzConfig& config)
+      : m_session(peel_fuzz_start(&config)) {}
+
+    FuzzSession(FuzzSession&& other) noexcept : m_session(other.m_session) {
+      other.m_session = nullptr;
+    }
+
+    FuzzSession(const FuzzSession&)             = delete;
+    FuzzSession& operator=(const FuzzSession&)  = delete;
+    FuzzSession& operator=(FuzzSession&&)       = delete;
+
+    ~FuzzSession() {
+      if (m_session) {
+        peel_fuzz_stop(m_session);
+        peel_fuzz_join(m_session);
+      }
+    }
+
+    bool valid() const { return m_session != nullptr; }
+
+    PeelFuzzStats stats() {
+      PeelFuzzStats stats {};
+      if (m_session) {
+        peel_fuzz_stats(m_session, &stats);
+      }
+      return stats;
+    }
+
+    void stop() {
+      if (m_session) {
+        peel_fuzz_stop(m_session);
+      }
+    }
+
+    // Blocks until the campaign exits. Returns its exit code, -1 if not running
+    int join() {
+      if (!m_session) {
+        return -1;
+      }
+      int code = peel_fuzz_join(m_session);
+      m_session = nullptr;
+      return code;
+    }
+};
+
 // C++ wrapper around rust ABI
 class PeelFuzz {
   private:
@@ -71,6 +226,116 @@ class PeelFuzz {
     PeelFuzz(const PeelFuzz&)             = delete;
     PeelFuzz& operator=(const PeelFuzz&)  = delete;
 
+    void setFixup(FixupFn fixup) {
+      m_config.fixup_fn = fixup;
+    }
+
+    void setChecksumRepair(bool enabled) {
+      m_config.checksum_repair = enabled ? 1 : 0;
+    }
+
+    // Strings and arrays passed below are not copied and must outlive the run
+
+    void setCrashDir(const char* dir) {
+      m_config.crash_dir = dir;
+    }
+
+    void setHangDir(const char* dir) {
+      m_config.hang_dir = dir;
+    }
+
+    void setTrimPct(uint32_t pct) {
+      m_config.trim_pct = pct;
+    }
+
+    void setMutatorType(MutatorType type) {
+      m_config.mutator_type = type;
+    }
+
+    void setStrategyPlan(const char* plan) {
+      m_config.strategy_plan = plan;
+    }
+
+    void setCustomMutator(CustomMutatorFn mutator, CustomCrossOverFn crossover = nullptr,
+                          CustomMutatorMode mode = CUSTOM_MUTATOR_ALONGSIDE) {
+      m_config.custom_mutator_fn   = mutator;
+      m_config.custom_crossover_fn = crossover;
+      m_config.custom_mutator_mode = mode;
+    }
+
+    void setGrammarFile(const char* path) {
+      m_config.grammar_file = path;
+    }
+
+    void setGrammarRules(const GrammarRule* rules, uint32_t count) {
+      m_config.grammar_rules      = rules;
+      m_config.grammar_rule_count = count;
+    }
+
+    void setMaxInputLen(uint32_t len) {
+      m_config.max_input_len = len;
+    }
+
+    void setLenControl(uint32_t lenControl) {
+      m_config.len_control = lenControl;
+    }
+
+    void setInputCacheSlots(uint32_t slots) {
+      m_config.input_cache_slots = slots;
+    }
+
+    void setStopAfterObjectives(uint32_t count) {
+      m_config.stop_after_objectives = count;
+    }
+
+    void setStopPlateau(uint32_t seconds) {
+      m_config.stop_plateau_sec = seconds;
+    }
+
+    void setStatsDir(const char* dir, uint32_t intervalSec = 0) {
+      m_config.stats_dir          = dir;
+      m_config.stats_interval_sec = intervalSec;
+    }
+
+    void setMonitorInterval(uint32_t seconds, bool perClient = false) {
+      m_config.monitor_interval_sec = seconds;
+      m_config.monitor_per_client   = perClient ? 1 : 0;
+    }
+
+    void setMetricsPort(uint16_t port) {
+      m_config.metrics_port = port;
+    }
+
+    void setStatsCallback(StatsFn callback, void* ctx = nullptr, uint32_t intervalMs = 0) {
+      m_config.stats_cb             = callback;
+      m_config.stats_cb_ctx         = ctx;
+      m_config.stats_cb_interval_ms = intervalMs;
+    }
+
+    void setSlowInputs(uint32_t count, const char* dir = nullptr) {
+      m_config.slow_input_count = count;
+      m_config.slow_dir         = dir;
+    }
+
+    void setFuzzMode(FuzzMode mode) {
+      m_config.fuzz_mode = mode;
+    }
+
+    void setPerfBudget(uint64_t hitBudget, const char* dir = nullptr) {
+      m_config.perf_hit_budget = hitBudget;
+      m_config.perf_dir        = dir;
+    }
+
+    void setLatencyBudget(uint64_t budgetUs, const char* dir = nullptr) {
+      m_config.latency_budget_us = budgetUs;
+      m_config.slow_inputs_dir   = dir;
+    }
+
+    // Fields without a setter, or for reading back what was set
+    PeelFuzzConfig& config() {
+      return m_config;
+    }
+
     void runFuzzer(uint64_t duration) {
       m_config.timer_sec = duration;
       peel_fuzz_run(&m_config);
@@ -80,4 +345,15 @@ class PeelFuzz {
       m_config.timer_sec = static_cast<uint64_t>(duration);
       peel_fuzz_run(&m_config);
     }
+
+    // Non-blocking variants: the campaign runs until the duration expires,
+    // stop() is called, or the returned session is destroyed
+    FuzzSession startFuzzer(uint64_t duration) {
+      m_config.timer_sec = duration;
+      return FuzzSession(m_config);
+    }
+
+    FuzzSession startFuzzer(FuzzDuration duration) {
+      return startFuzzer(static_cast<uint64_t>(duration));
+    }
 };
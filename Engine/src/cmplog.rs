@@ -0,0 +1,126 @@
+/// Comparison tracing via `-fsanitize-coverage=trace-cmp`.
+///
+/// Logging is off by default, so instrumented comparisons and edges cost one
+/// branch per call. A stage switches it on around a single execution to
+/// collect the operands of every comparison the target made. That stage only
+/// exists with std, so on no_std the hooks are empty.
+use core::ptr::{addr_of, addr_of_mut};
+
+/// Maximum number of comparisons recorded per execution.
+pub const CMP_LOG_SIZE: usize = 4096;
+
+/// One recorded comparison.
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct CmpEntry {
+    /// Comparison site: the last pc-guard hit before it, plus its ordinal
+    /// among the comparisons made since that guard.
+    pub site: u32,
+    /// Operand width in bytes.
+    pub width: u8,
+    pub a: u64,
+    pub b: u64,
+}
+
+static mut ENABLED: bool = false;
+static mut LOG: [CmpEntry; CMP_LOG_SIZE] = [CmpEntry {
+    site: 0,
+    width: 0,
+    a: 0,
+    b: 0,
+}; CMP_LOG_SIZE];
+static mut LOG_LEN: usize = 0;
+
+/// Last pc-guard index hit, written by `__sanitizer_cov_trace_pc_guard` while
+/// recording.
+pub static mut LAST_GUARD: u32 = 0;
+static mut SITE_GUARD: u32 = 0;
+static mut SITE_SEQ: u32 = 0;
+
+/// Clear the log and start recording comparisons.
+pub unsafe fn start() {
+    unsafe {
+        LOG_LEN = 0;
+        // No guard is u32::MAX, so the first comparison always opens a new site
+        // instead of continuing the previous recording's.
+        SITE_GUARD = u32::MAX;
+        LAST_GUARD = 0;
+        SITE_SEQ = 0;
+        ENABLED = true;
+    }
+}
+
+/// True between `start` and `stop`.
+#[inline(always)]
+pub unsafe fn recording() -> bool {
+    cfg!(feature = "std") && unsafe { ENABLED }
+}
+
+/// Stop recording and return the comparisons logged since `start`.
+pub unsafe fn stop() -> &'static [CmpEntry] {
+    unsafe {
+        ENABLED = false;
+        core::slice::from_raw_parts(addr_of!(LOG).cast::<CmpEntry>(), LOG_LEN)
+    }
+}
+
+#[inline(always)]
+unsafe fn record(width: u8, a: u64, b: u64) {
+    unsafe {
+        if !recording() || LOG_LEN >= CMP_LOG_SIZE {
+            return;
+        }
+        if SITE_GUARD == LAST_GUARD {
+            SITE_SEQ = SITE_SEQ.wrapping_add(1);
+        } else {
+            SITE_GUARD = LAST_GUARD;
+            SITE_SEQ = 0;
+        }
+        let site = (LAST_GUARD << 4) | SITE_SEQ.min(15);
+        (*addr_of_mut!(LOG))[LOG_LEN] = CmpEntry { site, width, a, b };
+        LOG_LEN += 1;
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __sanitizer_cov_trace_cmp1(a: u8, b: u8) {
+    unsafe { record(1, a as u64, b as u64) }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __sanitizer_cov_trace_cmp2(a: u16, b: u16) {
+    unsafe { record(2, a as u64, b as u64) }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __sanitizer_cov_trace_cmp4(a: u32, b: u32) {
+    unsafe { record(4, a as u64, b as u64) }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __sanitizer_cov_trace_cmp8(a: u64, b: u64) {
+    unsafe { record(8, a, b) }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __sanitizer_cov_trace_const_cmp1(a: u8, b: u8) {
+    unsafe { record(1, a as u64, b as u64) }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __sanitizer_cov_trace_const_cmp2(a: u16, b: u16) {
+    unsafe { record(2, a as u64, b as u64) }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __sanitizer_cov_trace_const_cmp4(a: u32, b: u32) {
+    unsafe { record(4, a as u64, b as u64) }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __sanitizer_cov_trace_const_cmp8(a: u64, b: u64) {
+    unsafe { record(8, a, b) }
+}
+
+/// Switch statements are not logged; checksum checks are plain comparisons.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __sanitizer_cov_trace_switch(_val: u64, _cases: *const u64) {}
@@ -3,11 +3,24 @@
 #[cfg(not(feature = "std"))]
 use alloc::string::String;
 
+use crate::targets::{CCustomCrossOverFn, CCustomMutatorFn, CFixupFn, CStatsFn};
+
 #[repr(C)]
 #[derive(Debug, Clone, Copy, PartialEq, Eq)]
 pub enum HarnessType {
     ByteSize = 0,
     String = 1,
+    /// Byte target fed inputs derived from a context-free grammar
+    /// (requires the `grammar` cargo feature).
+    Grammar = 2,
+}
+
+/// One grammar production: `nonterm` expands to `expansion`, which references
+/// other nonterminals as `{NAME}`.
+#[repr(C)]
+pub struct GrammarRule {
+    pub nonterm: *const i8,
+    pub expansion: *const i8,
 }
 
 #[repr(C)]
@@ -15,6 +28,63 @@ pub enum HarnessType {
 pub enum SchedulerType {
     Queue = 0,
     Weighted = 1,
+    /// Queue scheduling restricted to favored entries: for each edge, the
+    /// entry with the smallest length × exec time.
+    Minimized = 2,
+    /// AFLFast power schedules: weighted scheduling with calibration and a
+    /// power-aware mutational stage that spends energy on rare paths.
+    Fast = 3,
+    Explore = 4,
+    Exploit = 5,
+    Coe = 6,
+    Lin = 7,
+    Quad = 8,
+}
+
+#[repr(C)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum MutatorType {
+    /// Havoc with operators picked uniformly at random.
+    Havoc = 0,
+    /// MOpt particle-swarm scheduling of the havoc operators.
+    MOpt = 1,
+}
+
+#[repr(C)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum FuzzMode {
+    /// Search for new coverage; crashes and hangs are the objectives.
+    Coverage = 0,
+    /// PerfFuzz-style: also keep inputs that raise any edge's maximum hit
+    /// count, and report runs over the edge-hit budget.
+    Perf = 1,
+}
+
+#[repr(C)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum CustomMutatorMode {
+    /// Custom callbacks run as an extra stage after havoc.
+    Alongside = 0,
+    /// Custom callbacks replace havoc entirely.
+    Exclusive = 1,
+}
+
+/// Snapshot of a running campaign, aggregated over all clients.
+#[repr(C)]
+#[derive(Debug, Clone, Copy, Default)]
+pub struct PeelFuzzStats {
+    pub executions: u64,
+    pub execs_per_sec: f64,
+    pub corpus_count: u64,
+    pub objective_count: u64,
+    pub edges_hit: u64,
+    pub edges_total: u64,
+    pub run_time_sec: u64,
+    pub clients: u32,
+    /// 1 until the campaign has exited.
+    pub running: u32,
+    /// Percent of coverage map entries hit.
+    pub map_density: f64,
 }
 
 #[repr(C)]
@@ -32,6 +102,70 @@ pub struct PeelFuzzConfig {
     pub seed_count: u32,
     /// Number of cores for parallel fuzzing. 0 = auto-detect (all available cores).
     pub core_count: u32,
+    /// Path for hang (timeout) outputs. Null = "./hangs".
+    pub hang_dir: *const i8,
+    /// Percent of fuzzing time spent trimming new corpus entries. 0 = disabled.
+    pub trim_pct: u32,
+    /// Havoc operator scheduling. 0 = uniform havoc.
+    pub mutator_type: MutatorType,
+    /// Per-core strategy spec, e.g. "0=explore,1-3=queue+mopt". Null = same strategy on every core.
+    pub strategy_plan: *const i8,
+    /// libFuzzer-style custom mutator. Null = none.
+    pub custom_mutator_fn: Option<CCustomMutatorFn>,
+    /// libFuzzer-style custom crossover. Null = none.
+    pub custom_crossover_fn: Option<CCustomCrossOverFn>,
+    /// Whether the custom callbacks run next to havoc or instead of it.
+    pub custom_mutator_mode: CustomMutatorMode,
+    /// Repairs checksums/length fields of each input before it runs or is saved. Null = none.
+    pub fixup_fn: Option<CFixupFn>,
+    /// Detect checksum comparisons and repair inputs to pass them (needs trace-cmp). 0 = disabled.
+    pub checksum_repair: u32,
+    /// JSON grammar for HARNESS_GRAMMAR, e.g. [["Expr","{Expr}+1"],["Expr","1"]]. Null = use grammar_rules.
+    pub grammar_file: *const i8,
+    /// Inline grammar for HARNESS_GRAMMAR; the first rule's nonterminal is the start symbol.
+    pub grammar_rules: *const GrammarRule,
+    pub grammar_rule_count: u32,
+    /// Hard limit on input length in bytes. 0 = default (1 MiB).
+    pub max_input_len: u32,
+    /// libFuzzer-style length control: start short and grow the cap on coverage plateaus. 0 = disabled.
+    pub len_control: u32,
+    /// Slots in the per-client recent-input hash cache. 0 = disabled (65536 for HARNESS_STRING).
+    pub input_cache_slots: u32,
+    /// Stop all cores after this many objectives (1 = first crash). 0 = never.
+    pub stop_after_objectives: u32,
+    /// Stop all cores after this many seconds without a new edge. 0 = never.
+    pub stop_plateau_sec: u32,
+    /// Directory for AFL-style `fuzzer_stats` and `plot_data`. Null = disabled.
+    pub stats_dir: *const i8,
+    /// Seconds between stats file updates. 0 = default (5s).
+    pub stats_interval_sec: u32,
+    /// Print one aggregate status line every this many seconds. 0 = a line per client event.
+    pub monitor_interval_sec: u32,
+    /// With `monitor_interval_sec`, add a detail line per client to each summary. 0 = disabled.
+    pub monitor_per_client: u32,
+    /// Local port for the broker's OpenMetrics endpoint. 0 = disabled.
+    pub metrics_port: u16,
+    /// Called with aggregate stats from the process that runs the monitor. Null = none.
+    pub stats_cb: Option<CStatsFn>,
+    /// Passed back to `stats_cb` unchanged.
+    pub stats_cb_ctx: *mut core::ffi::c_void,
+    /// Minimum milliseconds between two `stats_cb` calls. 0 = on every stats event
+    /// the broker aggregates (at most every 250 ms with std).
+    pub stats_cb_interval_ms: u32,
+    /// Directory for the slowest corpus entries. Null = "./slow".
+    pub slow_dir: *const i8,
+    /// How many of the slowest corpus entries to keep in `slow_dir`. 0 = disabled.
+    pub slow_input_count: u32,
+    /// What the campaign searches for. 0 = coverage.
+    pub fuzz_mode: FuzzMode,
+    /// PERF mode: runs with more edge hits than this are objectives, also written to `perf_dir`. 0 = no budget.
+    pub perf_hit_budget: u64,
+    /// PERF mode: directory for inputs over the hit budget. Null = "./perf".
+    pub perf_dir: *const i8,
+    /// Inputs whose run time stays over this many microseconds on re-runs are objectives, also written to slow_inputs_dir. 0 = disabled.
+    pub latency_budget_us: u64,
+    /// Path for latency-budget outputs. Null = "./slow_inputs".
+    pub slow_inputs_dir: *const i8,
 }
 
 impl PeelFuzzConfig {
@@ -76,6 +210,21 @@ impl PeelFuzzConfig {
         }
     }
 
+    pub fn max_input_len_or_default(&self) -> usize {
+        if self.max_input_len == 0 {
+            crate::engine::DEFAULT_MAX_INPUT_LEN
+        } else {
+            self.max_input_len as usize
+        }
+    }
+
+    pub fn input_cache_slots_or_default(&self) -> usize {
+        match (self.input_cache_slots, self.harness_type) {
+            (0, HarnessType::String) => crate::dedup::DEFAULT_STRING_CACHE_SLOTS,
+            (slots, _) => slots as usize,
+        }
+    }
+
     pub fn crash_dir_or_default(&self) -> String {
         if self.crash_dir.is_null() {
             "./crashes".into()
@@ -87,4 +236,86 @@ impl PeelFuzzConfig {
             }
         }
     }
+
+    pub fn strategy_plan_or_default(&self) -> String {
+        if self.strategy_plan.is_null() {
+            String::new()
+        } else {
+            unsafe {
+                core::ffi::CStr::from_ptr(self.strategy_plan.cast())
+                    .to_string_lossy()
+                    .into_owned()
+            }
+        }
+    }
+
+    pub fn slow_inputs_dir_or_default(&self) -> String {
+        if self.slow_inputs_dir.is_null() {
+            "./slow_inputs".into()
+        } else {
+            unsafe {
+                core::ffi::CStr::from_ptr(self.slow_inputs_dir.cast())
+                    .to_string_lossy()
+                    .into_owned()
+            }
+        }
+    }
+
+    pub fn perf_dir_or_default(&self) -> String {
+        if self.perf_dir.is_null() {
+            "./perf".into()
+        } else {
+            unsafe {
+                core::ffi::CStr::from_ptr(self.perf_dir.cast())
+                    .to_string_lossy()
+                    .into_owned()
+            }
+        }
+    }
+
+    pub fn slow_dir_or_default(&self) -> String {
+        if self.slow_dir.is_null() {
+            "./slow".into()
+        } else {
+            unsafe {
+                core::ffi::CStr::from_ptr(self.slow_dir.cast())
+                    .to_string_lossy()
+                    .into_owned()
+            }
+        }
+    }
+
+    pub fn stats_interval_sec_or_default(&self) -> u64 {
+        if self.stats_interval_sec == 0 {
+            5
+        } else {
+            self.stats_interval_sec as u64
+        }
+    }
+
+    pub fn stats_dir_or_default(&self) -> Option<String> {
+        if self.stats_dir.is_null() {
+            None
+        } else {
+            unsafe {
+                Some(
+                    core::ffi::CStr::from_ptr(self.stats_dir.cast())
+                        .to_string_lossy()
+                        .into_owned(),
+                )
+            }
+        }
+    }
+
+    pub fn hang_dir_or_default(&self) -> String {
+        if self.hang_dir.is_null() {
+            "./hangs".into()
+        } else {
+            unsafe {
+                core::ffi::CStr::from_ptr(self.hang_dir.cast())
+                    .to_string_lossy()
+                    .into_owned()
+            }
+        }
+    }
 }
@@ -0,0 +1,178 @@
+/// Skips executions of inputs that were run recently.
+use core::cell::Cell;
+
+use libafl::fuzzer::InputFilter;
+use libafl::inputs::{BytesInput, HasTargetBytes};
+use libafl_bolts::{AsSlice, hash_std};
+
+#[cfg(not(feature = "std"))]
+use alloc::{rc::Rc, vec, vec::Vec};
+#[cfg(feature = "std")]
+use std::rc::Rc;
+
+/// Cache size used for string targets when none is configured: 64K hashes,
+/// 512 KiB per client.
+pub const DEFAULT_STRING_CACHE_SLOTS: usize = 1 << 16;
+
+/// Direct-mapped table of input hashes: each hash owns one slot and evicts
+/// whatever was there, so lookups are a single load and the table never grows.
+pub struct RecentInputs {
+    slots: Vec<u64>,
+    mask: usize,
+}
+
+impl RecentInputs {
+    /// A table of `slots` entries, rounded up to a power of two. 0 disables it.
+    pub fn new(slots: usize) -> Self {
+        let len = if slots == 0 {
+            0
+        } else {
+            slots.next_power_of_two()
+        };
+        Self {
+            slots: vec![0; len],
+            mask: len.wrapping_sub(1),
+        }
+    }
+
+    pub fn is_enabled(&self) -> bool {
+        !self.slots.is_empty()
+    }
+
+    /// Record `hash`. Returns true if it was already in the table.
+    #[inline]
+    pub fn check_and_insert(&mut self, hash: u64) -> bool {
+        if self.slots.is_empty() {
+            return false;
+        }
+        let slot = &mut self.slots[(hash ^ (hash >> 32)) as usize & self.mask];
+        // Slot value 0 means empty, so the stored tag is never 0.
+        let tag = hash | 1;
+        if *slot == tag {
+            true
+        } else {
+            *slot = tag;
+            false
+        }
+    }
+}
+
+/// Input filter for the mutational stages: an input whose bytes match a
+/// recently executed one is not run again, saving the target call and the
+/// coverage reset. Clients are single-threaded, so the table needs no locking.
+///
+/// For string targets only the bytes before the first NUL are compared, since
+/// that is all the target sees. Stages that re-run inputs on purpose
+/// (calibration, trimming, generalization) bypass the filter.
+pub struct RecentInputFilter {
+    recent: RecentInputs,
+    effective_string: bool,
+    stats: Rc<CacheStats>,
+}
+
+/// Lookups and hits of a `RecentInputFilter`, shared with the client loop
+/// that reports them.
+#[derive(Debug, Default)]
+pub struct CacheStats {
+    pub lookups: Cell<u64>,
+    pub hits: Cell<u64>,
+}
+
+impl RecentInputFilter {
+    /// A filter over `slots` recent hashes. 0 disables it.
+    pub fn new(slots: usize, effective_string: bool) -> Self {
+        Self {
+            recent: RecentInputs::new(slots),
+            effective_string,
+            stats: Rc::default(),
+        }
+    }
+
+    pub fn is_enabled(&self) -> bool {
+        self.recent.is_enabled()
+    }
+
+    /// Handle to the hit counters, which stays valid after the filter moves
+    /// into the fuzzer.
+    pub fn stats(&self) -> Rc<CacheStats> {
+        Rc::clone(&self.stats)
+    }
+}
+
+impl InputFilter<BytesInput> for RecentInputFilter {
+    fn should_execute(&mut self, input: &BytesInput) -> bool {
+        if !self.recent.is_enabled() {
+            return true;
+        }
+        let target = input.target_bytes();
+        let mut bytes = target.as_slice();
+        if self.effective_string {
+            if let Some(nul) = bytes.iter().position(|&b| b == 0) {
+                bytes = &bytes[..nul];
+            }
+        }
+        let hit = self.recent.check_and_insert(hash_std(bytes));
+        self.stats.lookups.set(self.stats.lookups.get() + 1);
+        self.stats.hits.set(self.stats.hits.get() + hit as u64);
+        !hit
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn disabled_table_never_hits() {
+        let mut recent = RecentInputs::new(0);
+        assert!(!recent.is_enabled());
+        assert!(!recent.check_and_insert(42));
+        assert!(!recent.check_and_insert(42));
+    }
+
+    #[test]
+    fn repeated_hash_hits() {
+        let mut recent = RecentInputs::new(100);
+        assert_eq!(recent.slots.len(), 128);
+        assert!(!recent.check_and_insert(42));
+        assert!(recent.check_and_insert(42));
+        assert!(!recent.check_and_insert(43));
+        assert!(recent.check_and_insert(42));
+    }
+
+    #[test]
+    fn zero_hash_is_recorded() {
+        let mut recent = RecentInputs::new(16);
+        assert!(!recent.check_and_insert(0));
+        assert!(recent.check_and_insert(0));
+    }
+
+    #[test]
+    fn same_slot_evicts() {
+        let mut recent = RecentInputs::new(16);
+        // Both map to slot 2 of 16.
+        let (a, b) = (2, 2 + 16);
+        assert!(!recent.check_and_insert(a));
+        assert!(!recent.check_and_insert(b));
+        assert!(!recent.check_and_insert(a));
+    }
+
+    #[test]
+    fn string_filter_compares_up_to_nul() {
+        let mut filter = RecentInputFilter::new(16, true);
+        assert!(filter.should_execute(&BytesInput::new(b"ab\0x".to_vec())));
+        assert!(!filter.should_execute(&BytesInput::new(b"ab\0y".to_vec())));
+        assert!(filter.should_execute(&BytesInput::new(b"abc".to_vec())));
+
+        let stats = filter.stats();
+        assert_eq!((stats.lookups.get(), stats.hits.get()), (3, 1));
+    }
+
+    #[test]
+    fn byte_filter_compares_whole_input() {
+        let mut filter = RecentInputFilter::new(16, false);
+        assert!(filter.should_execute(&BytesInput::new(b"ab\0x".to_vec())));
+        assert!(filter.should_execute(&BytesInput::new(b"ab\0y".to_vec())));
+        assert!(!filter.should_execute(&BytesInput::new(b"ab\0y".to_vec())));
+    }
+}
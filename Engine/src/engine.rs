@@ -1,4 +1,5 @@
-use crate::config::SchedulerType;
+use crate::config::{CustomMutatorMode, FuzzMode, MutatorType, SchedulerType};
+use crate::targets::{CCustomCrossOverFn, CCustomMutatorFn, CFixupFn, CStatsFn};
 use core::time::Duration;
 use libafl::executors::ExitKind;
 use libafl::inputs::BytesInput;
@@ -6,26 +7,94 @@ use libafl::inputs::BytesInput;
 #[cfg(not(feature = "std"))]
 use alloc::string::String;
 
-/// Builder for configuring and running a PeelFuzz fuzzing session.
-pub struct PeelFuzzer<H>
-where
-    H: FnMut(&BytesInput) -> ExitKind,
-{
-    harness: H,
-    scheduler_type: SchedulerType,
-    timeout: Duration,
-    fuzz_duration: Duration,
-    crash_dir: String,
-    seed_count: usize,
-    core_count: usize,
+/// Default hard limit on input length (LibAFL's default max size).
+pub const DEFAULT_MAX_INPUT_LEN: usize = 1 << 20;
+
+/// Engine settings shared by every fuzzing client.
+#[derive(Debug, Clone)]
+pub struct FuzzOptions {
+    pub scheduler_type: SchedulerType,
+    pub mutator_type: MutatorType,
+    pub timeout: Duration,
+    pub fuzz_duration: Duration,
+    pub crash_dir: String,
+    pub hang_dir: String,
+    /// Directory for the slowest corpus entries.
+    pub slow_dir: String,
+    /// How many of the slowest corpus entries to keep in `slow_dir`. 0 = disabled.
+    pub slow_input_count: usize,
+    /// PERF mode keeps inputs that raise any edge's maximum hit count.
+    pub fuzz_mode: FuzzMode,
+    /// PERF mode: runs with more edge hits than this are objectives. 0 = none.
+    pub perf_hit_budget: u64,
+    /// PERF mode: directory for runs over the hit budget.
+    pub perf_dir: String,
+    /// Runs confirmed slower than this many microseconds are objectives, also written to slow_inputs_dir. 0 = disabled.
+    pub latency_budget_us: u64,
+    /// Directory for inputs over the latency budget.
+    pub slow_inputs_dir: String,
+    pub seed_count: usize,
+    pub core_count: usize,
+    /// Percent of fuzzing time spent trimming new corpus entries. 0 = disabled.
+    pub trim_pct: u32,
+    /// Per-core strategy overrides; cores without an entry use the fields above.
+    #[cfg(feature = "std")]
+    pub strategy_plan: crate::strategy::StrategyPlan,
+    pub custom_mutator: Option<CCustomMutatorFn>,
+    pub custom_crossover: Option<CCustomCrossOverFn>,
+    pub custom_mutator_mode: CustomMutatorMode,
+    /// Repairs checksums and length fields of every generated or mutated input.
+    pub fixup: Option<CFixupFn>,
+    /// Detect checksum comparisons from trace-cmp logs and repair inputs to pass them.
+    pub checksum_repair: bool,
+    /// Grimoire generalization and structural mutation, for text-like inputs.
+    pub grimoire: bool,
+    /// Inputs are C strings: printable seeds, UTF-8 text mutations, and
+    /// duplicates of a recently run effective string are skipped.
+    pub string_input: bool,
+    /// Hard limit on input length; longer inputs never reach the target.
+    pub max_input_len: usize,
+    /// libFuzzer-style length control: runs without new coverage, per log2 of
+    /// the cap, before the cap grows. 0 = cap fixed at `max_input_len`.
+    pub len_control: u32,
+    /// Slots in the per-client cache of recently executed input hashes. 0 = disabled.
+    pub input_cache_slots: usize,
+    /// Stop every client once this many objectives were found. 0 = never.
+    #[cfg(feature = "std")]
+    pub stop_objectives: u64,
+    /// Stop every client once no new edge was found for this long.
+    #[cfg(feature = "std")]
+    pub stop_plateau: Option<Duration>,
+    /// Directory for `fuzzer_stats` and `plot_data`, written by the broker. None = disabled.
+    #[cfg(feature = "std")]
+    pub stats_dir: Option<String>,
+    /// How often the broker rewrites the stats files.
+    #[cfg(feature = "std")]
+    pub stats_interval: Duration,
+    /// Print one aggregate status line per interval instead of one per client
+    /// event. None = a line per event.
+    #[cfg(feature = "std")]
+    pub monitor_interval: Option<Duration>,
+    /// Add per-client detail lines to each aggregate status line.
+    #[cfg(feature = "std")]
+    pub monitor_per_client: bool,
+    /// Local port for the broker's OpenMetrics endpoint. None = disabled.
+    #[cfg(feature = "std")]
+    pub metrics_port: Option<u16>,
+    /// C callback handed aggregate stats by the monitor.
+    pub stats_cb: Option<crate::monitors::StatsCallback>,
 }
 
-impl<H> PeelFuzzer<H>
-where
-    H: FnMut(&BytesInput) -> ExitKind,
-{
-    /// Create a new fuzzer with the given harness and sensible defaults.
-    pub fn new(harness: H) -> Self {
+impl FuzzOptions {
+    /// Whether the havoc stages run; only false when custom callbacks replace them.
+    pub fn havoc_enabled(&self) -> bool {
+        self.custom_mutator_mode == CustomMutatorMode::Alongside
+            || (self.custom_mutator.is_none() && self.custom_crossover.is_none())
+    }
+}
+
+impl Default for FuzzOptions {
+    fn default() -> Self {
         let core_count = {
             #[cfg(feature = "std")]
             {
@@ -40,240 +109,788 @@ where
         };
 
         Self {
-            harness,
             scheduler_type: SchedulerType::Queue,
+            mutator_type: MutatorType::Havoc,
             timeout: Duration::from_secs(1),
             fuzz_duration: Duration::from_secs(300),
             crash_dir: "./crashes".into(),
+            hang_dir: "./hangs".into(),
+            slow_dir: "./slow".into(),
+            slow_input_count: 0,
+            fuzz_mode: FuzzMode::Coverage,
+            perf_hit_budget: 0,
+            perf_dir: "./perf".into(),
+            latency_budget_us: 0,
+            slow_inputs_dir: "./slow_inputs".into(),
             seed_count: 8,
             core_count,
+            trim_pct: 0,
+            #[cfg(feature = "std")]
+            strategy_plan: Default::default(),
+            custom_mutator: None,
+            custom_crossover: None,
+            custom_mutator_mode: CustomMutatorMode::Alongside,
+            fixup: None,
+            checksum_repair: false,
+            grimoire: false,
+            string_input: false,
+            max_input_len: DEFAULT_MAX_INPUT_LEN,
+            len_control: 0,
+            input_cache_slots: 0,
+            #[cfg(feature = "std")]
+            stop_objectives: 0,
+            #[cfg(feature = "std")]
+            stop_plateau: None,
+            #[cfg(feature = "std")]
+            stats_dir: None,
+            #[cfg(feature = "std")]
+            stats_interval: Duration::from_secs(5),
+            #[cfg(feature = "std")]
+            monitor_interval: None,
+            #[cfg(feature = "std")]
+            monitor_per_client: false,
+            #[cfg(feature = "std")]
+            metrics_port: None,
+            stats_cb: None,
+        }
+    }
+}
+
+/// Builder for configuring and running a PeelFuzz fuzzing session.
+///
+/// `H` is the harness: a closure over `BytesInput` for the byte and string
+/// modes, or a grammar target for grammar mode.
+pub struct PeelFuzzer<H> {
+    pub(crate) harness: H,
+    pub(crate) opts: FuzzOptions,
+}
+
+impl<H> PeelFuzzer<H> {
+    /// Create a new fuzzer with the given harness and sensible defaults.
+    pub fn new(harness: H) -> Self {
+        Self {
+            harness,
+            opts: FuzzOptions::default(),
         }
     }
 
     /// Select the scheduler strategy.
     pub fn scheduler(mut self, scheduler_type: SchedulerType) -> Self {
-        self.scheduler_type = scheduler_type;
+        self.opts.scheduler_type = scheduler_type;
+        self
+    }
+
+    /// Select how havoc mutation operators are scheduled.
+    pub fn mutator(mut self, mutator_type: MutatorType) -> Self {
+        self.opts.mutator_type = mutator_type;
         self
     }
 
     /// Set the executor timeout per input.
     pub fn timeout(mut self, timeout: Duration) -> Self {
-        self.timeout = timeout;
+        self.opts.timeout = timeout;
         self
     }
 
     /// Set the directory for crash outputs.
     pub fn crash_dir(mut self, dir: &str) -> Self {
-        self.crash_dir = dir.into();
+        self.opts.crash_dir = dir.into();
+        self
+    }
+
+    /// Set the directory for hang (timeout) outputs.
+    pub fn hang_dir(mut self, dir: &str) -> Self {
+        self.opts.hang_dir = dir.into();
+        self
+    }
+
+    /// Keep the `count` slowest corpus entries in `dir`. 0 = disabled.
+    pub fn slow_inputs(mut self, dir: &str, count: usize) -> Self {
+        self.opts.slow_dir = dir.into();
+        self.opts.slow_input_count = count;
+        self
+    }
+
+    /// Select coverage or PERF mode. In PERF mode, runs with more than
+    /// `hit_budget` edge hits are objectives, also written to `dir`
+    /// (0 = no budget). Use `latency_budget` for a time budget.
+    pub fn fuzz_mode(mut self, mode: FuzzMode, hit_budget: u64, dir: &str) -> Self {
+        self.opts.fuzz_mode = mode;
+        self.opts.perf_hit_budget = hit_budget;
+        self.opts.perf_dir = dir.into();
+        self
+    }
+
+    /// Report inputs whose run time stays over `budget_us` on re-runs, into
+    /// `dir`. 0 = disabled.
+    pub fn latency_budget(mut self, budget_us: u64, dir: &str) -> Self {
+        self.opts.latency_budget_us = budget_us;
+        self.opts.slow_inputs_dir = dir.into();
         self
     }
 
     /// Set the number of initial seed inputs.
     pub fn seed_count(mut self, count: usize) -> Self {
-        self.seed_count = count;
+        self.opts.seed_count = count;
         self
     }
 
     /// Set the total duration for the fuzzing session.
     pub fn fuzz_duration(mut self, dur: Duration) -> Self {
-        self.fuzz_duration = dur;
+        self.opts.fuzz_duration = dur;
         self
     }
 
     /// Set the number of cores for parallel fuzzing.
     pub fn core_count(mut self, count: usize) -> Self {
-        self.core_count = count;
+        self.opts.core_count = count;
+        self
+    }
+
+    /// Set the share of fuzzing time (in percent) spent trimming corpus entries.
+    pub fn trim_pct(mut self, pct: u32) -> Self {
+        self.opts.trim_pct = pct;
+        self
+    }
+
+    /// Set the per-core strategy plan (see `strategy.rs` for the spec format).
+    /// An invalid plan is reported and ignored, so every core falls back to
+    /// the scheduler and mutator type; this runs under the C ABI, where a
+    /// panic must not unwind.
+    #[cfg(feature = "std")]
+    pub fn strategy_plan(mut self, spec: &str) -> Self {
+        match crate::strategy::StrategyPlan::parse(spec) {
+            Ok(plan) => self.opts.strategy_plan = plan,
+            Err(e) => println!(
+                "[PeelFuzz] Ignoring invalid strategy plan \"{spec}\": {e}. \
+                 All cores use scheduler_type / mutator_type."
+            ),
+        }
+        self
+    }
+
+    /// Set libFuzzer-style custom mutator and crossover callbacks, run next to
+    /// havoc or instead of it depending on `mode`.
+    pub fn custom_mutator(
+        mut self,
+        mutate_fn: Option<CCustomMutatorFn>,
+        crossover_fn: Option<CCustomCrossOverFn>,
+        mode: CustomMutatorMode,
+    ) -> Self {
+        self.opts.custom_mutator = mutate_fn;
+        self.opts.custom_crossover = crossover_fn;
+        self.opts.custom_mutator_mode = mode;
+        self
+    }
+
+    /// Set a callback that fixes up every seed and mutated input before it runs.
+    pub fn fixup(mut self, fixup: Option<CFixupFn>) -> Self {
+        self.opts.fixup = fixup;
+        self
+    }
+
+    /// Enable automatic checksum detection and repair. The target must be
+    /// built with `-fsanitize-coverage=trace-cmp`.
+    pub fn checksum_repair(mut self, enabled: bool) -> Self {
+        self.opts.checksum_repair = enabled;
+        self
+    }
+
+    /// Enable Grimoire: generalize new corpus entries and recombine the
+    /// generalized fragments. On by default for `HARNESS_STRING` targets.
+    pub fn grimoire(mut self, enabled: bool) -> Self {
+        self.opts.grimoire = enabled;
+        self
+    }
+
+    /// Treat inputs as C strings (set automatically for `HARNESS_STRING`).
+    pub fn string_input(mut self, enabled: bool) -> Self {
+        self.opts.string_input = enabled;
+        self
+    }
+
+    /// Set the hard limit on input length.
+    pub fn max_input_len(mut self, len: usize) -> Self {
+        self.opts.max_input_len = len;
+        self
+    }
+
+    /// Start with short inputs and raise the length cap when coverage
+    /// plateaus (libFuzzer's `-len_control`). 0 = disabled.
+    pub fn len_control(mut self, runs_per_log: u32) -> Self {
+        self.opts.len_control = runs_per_log;
+        self
+    }
+
+    /// Size the per-client cache of recent input hashes used to skip
+    /// duplicate executions. 0 = disabled.
+    pub fn input_cache_slots(mut self, slots: usize) -> Self {
+        self.opts.input_cache_slots = slots;
+        self
+    }
+
+    /// Stop the whole campaign once `count` objectives were found (1 = on the
+    /// first crash). 0 = never.
+    #[cfg(feature = "std")]
+    pub fn stop_after_objectives(mut self, count: u64) -> Self {
+        self.opts.stop_objectives = count;
+        self
+    }
+
+    /// Stop the whole campaign once no new edge was found for `plateau`.
+    #[cfg(feature = "std")]
+    pub fn stop_on_plateau(mut self, plateau: Option<Duration>) -> Self {
+        self.opts.stop_plateau = plateau;
+        self
+    }
+
+    /// Write AFL-style `fuzzer_stats` and `plot_data` into `dir` every
+    /// `interval`. None = disabled.
+    #[cfg(feature = "std")]
+    pub fn stats_dir(mut self, dir: Option<&str>, interval: Duration) -> Self {
+        self.opts.stats_dir = dir.map(Into::into);
+        self.opts.stats_interval = interval;
+        self
+    }
+
+    /// Rate-limit the broker's status output to one aggregate line per
+    /// `interval`, optionally followed by a line per client. None = a line
+    /// per client event.
+    #[cfg(feature = "std")]
+    pub fn monitor_interval(mut self, interval: Option<Duration>, per_client: bool) -> Self {
+        self.opts.monitor_interval = interval;
+        self.opts.monitor_per_client = per_client;
+        self
+    }
+
+    /// Serve OpenMetrics campaign telemetry from the broker on
+    /// `127.0.0.1:port`. None = disabled.
+    #[cfg(feature = "std")]
+    pub fn metrics_port(mut self, port: Option<u16>) -> Self {
+        self.opts.metrics_port = port;
+        self
+    }
+
+    /// Call `func(stats, ctx)` with aggregate stats at most once per
+    /// `interval` (zero = each time the broker aggregates). With std it runs in the
+    /// broker, i.e. the process that called `run`.
+    pub fn stats_callback(
+        mut self,
+        func: Option<CStatsFn>,
+        ctx: *mut core::ffi::c_void,
+        interval: Duration,
+    ) -> Self {
+        self.opts.stats_cb = func.map(|func| crate::monitors::StatsCallback {
+            func,
+            ctx,
+            interval,
+        });
         self
     }
 
     /// Run the fuzzer (std build — multicore, fork-based).
     #[cfg(feature = "std")]
-    pub unsafe fn run(self) {
-        let PeelFuzzer {
-            mut harness,
-            scheduler_type,
-            timeout,
-            fuzz_duration,
-            crash_dir,
-            seed_count,
-            core_count,
-        } = self;
+    pub unsafe fn run(self)
+    where
+        H: FnMut(&BytesInput) -> ExitKind,
+    {
+        let PeelFuzzer { mut harness, opts } = self;
 
-        let mon = crate::monitors::multi_monitor();
-        match scheduler_type {
-            SchedulerType::Queue => {
-                run_engine_multicore!(
-                    harness,
-                    mon,
-                    crash_dir,
-                    seed_count,
-                    timeout,
-                    core_count,
-                    fuzz_duration,
-                    |_s, _o| { libafl::schedulers::QueueScheduler::new() }
-                );
-            }
-            SchedulerType::Weighted => {
-                run_engine_multicore!(
-                    harness,
-                    mon,
-                    crash_dir,
-                    seed_count,
-                    timeout,
-                    core_count,
-                    fuzz_duration,
-                    |state, observer| crate::schedulers::StdWeightedScheduler::new(
-                        &mut state, &observer
-                    )
-                );
-            }
-        }
+        let mon = crate::monitors::multi_monitor(&opts);
+        run_engine_multicore!(fuzz_client, BytesInput, harness, mon, opts);
     }
 
     /// Run the fuzzer (no_std build — single-core, in-memory only).
     #[cfg(not(feature = "std"))]
-    pub unsafe fn run(self) {
-        let PeelFuzzer {
-            mut harness,
-            scheduler_type,
-            seed_count,
-            ..
-        } = self;
-
-        let mon = crate::monitors::simple_monitor();
-        match scheduler_type {
+    pub unsafe fn run(self)
+    where
+        H: FnMut(&BytesInput) -> ExitKind,
+    {
+        let PeelFuzzer { mut harness, opts } = self;
+
+        let mon = crate::monitors::simple_monitor(&opts);
+        match opts.scheduler_type {
             SchedulerType::Queue => {
-                run_engine_singlecore!(harness, mon, seed_count, |_s, _o| {
+                run_engine_singlecore!(harness, mon, opts, false, |_s, _o| {
                     libafl::schedulers::QueueScheduler::new()
                 });
             }
             SchedulerType::Weighted => {
-                run_engine_singlecore!(harness, mon, seed_count, |state, observer| {
+                run_engine_singlecore!(harness, mon, opts, false, |state, observer| {
                     crate::schedulers::StdWeightedScheduler::new(&mut state, &observer)
                 });
             }
+            SchedulerType::Minimized => {
+                run_engine_singlecore!(harness, mon, opts, true, |_s, observer| {
+                    crate::schedulers::IndexesLenTimeMinimizerScheduler::new(
+                        &observer,
+                        libafl::schedulers::QueueScheduler::new(),
+                    )
+                });
+            }
+            power => {
+                let schedule = crate::schedulers::power_schedule(power);
+                run_engine_singlecore!(harness, mon, opts, false, |state, observer| {
+                    crate::schedulers::StdWeightedScheduler::with_schedule(
+                        &mut state, &observer, schedule,
+                    )
+                });
+            }
         }
     }
 }
 
+/// How often each client reports its own stats (input cache hit rate,
+/// exec-time histogram, introspection timings).
+#[cfg(feature = "std")]
+pub(crate) const STATS_REPORT_INTERVAL: Duration = Duration::from_secs(5);
+
+/// Share of this client's cycles since `start_cycles` spent in
+/// `reset_coverage`. LibAFL's own introspection counts it as target execution,
+/// since it runs inside the harness.
+#[cfg(feature = "introspection")]
+pub(crate) fn reset_coverage_stats<I>(start_cycles: u64) -> libafl::events::Event<I> {
+    use libafl::statistics::user_stats::{AggregatorOps, UserStats, UserStatsValue};
+
+    let reset = crate::sanitizer_coverage::RESET_CYCLES.load(core::sync::atomic::Ordering::Relaxed);
+    let elapsed = libafl_bolts::cpu::read_time_counter().saturating_sub(start_cycles);
+    libafl::events::Event::UpdateUserStats {
+        name: std::borrow::Cow::Borrowed("reset_coverage"),
+        value: UserStats::new(UserStatsValue::Ratio(reset, elapsed), AggregatorOps::Avg),
+        phantom: core::marker::PhantomData,
+    }
+}
+
+// Expands to `$then` if the flag token is `true` and to `$else` if it is
+// `false`. Map observer tracking is part of the observer's type, so it is
+// chosen per macro instantiation: index tracking only where the minimizer
+// scheduler needs it, novelty tracking only where Grimoire does.
+macro_rules! static_if {
+    (true, $then:expr, $else:expr) => {
+        $then
+    };
+    (false, $then:expr, $else:expr) => {
+        $else
+    };
+}
+
+pub(crate) use static_if;
+
 // ---------------------------------------------------------------------------
-// std: Multicore macro using LibAFL Launcher with fork-based parallelism.
+// std: Per-client fuzzing loop, instantiated once per scheduler type, and
+// once more with Grimoire's novelty tracking.
 // ---------------------------------------------------------------------------
 #[cfg(feature = "std")]
-macro_rules! run_engine_multicore {
-    ($harness:expr, $monitor:expr, $crash_dir:expr, $seed_count:expr, $timeout:expr, $core_count:expr, $fuzz_duration:expr,
+macro_rules! fuzz_client {
+    ($harness:expr, $mgr:ident, $opts:expr, $strategy:expr, $indices:tt,
+     |$state:ident, $observer:ident| $make_scheduler:expr) => {
+        if $opts.grimoire {
+            fuzz_client!(@run true, $harness, $mgr, $opts, $strategy, $indices,
+                |$state, $observer| $make_scheduler)
+        } else {
+            fuzz_client!(@run false, $harness, $mgr, $opts, $strategy, $indices,
+                |$state, $observer| $make_scheduler)
+        }
+    };
+    (@run $novelties:tt, $harness:expr, $mgr:ident, $opts:expr, $strategy:expr, $indices:tt,
      |$state:ident, $observer:ident| $make_scheduler:expr) => {{
+        use core::marker::PhantomData;
         use core::num::NonZero;
+        use std::borrow::Cow;
         use std::path::PathBuf;
 
         use libafl::{
+            Error,
             corpus::{Corpus, InMemoryCorpus, OnDiskCorpus},
-            events::{EventConfig, launcher::Launcher},
+            events::{Event, EventFirer},
             feedbacks::{
-                CrashFeedback, EagerOrFeedback, MaxMapFeedback, TimeFeedback, TimeoutFeedback,
+                CrashFeedback, EagerOrFeedback, FastAndFeedback, MaxMapFeedback, TimeFeedback,
             },
             fuzzer::{Fuzzer, StdFuzzer},
-            generators::RandBytesGenerator,
-            mutators::{havoc_mutations::havoc_mutations, scheduled::HavocScheduledMutator},
-            observers::{StdMapObserver, TimeObserver},
-            stages::mutational::StdMutationalStage,
-            state::{HasCorpus, StdState},
+            mutators::{
+                GrimoireExtensionMutator, GrimoireRandomDeleteMutator,
+                GrimoireRecursiveReplacementMutator, GrimoireStringReplacementMutator,
+                StdMOptMutator, havoc_mutations::havoc_mutations, scheduled::HavocScheduledMutator,
+            },
+            observers::{BacktraceObserver, HarnessType, StdMapObserver, TimeObserver},
+            stages::{
+                CalibrationStage, GeneralizationStage, IfStage, StdPowerMutationalStage,
+                mutational::StdMutationalStage,
+            },
+            state::{HasCorpus, HasMaxSize, StdState},
+            statistics::user_stats::{AggregatorOps, UserStats, UserStatsValue},
+        };
+        use libafl_bolts::{HasLen, current_nanos, rands::StdRand, tuples::tuple_list};
+
+        use crate::dedup::RecentInputFilter;
+        use crate::exec_time::ExecTimeFeedback;
+        use crate::generators::{FixupGenerator, SeedGenerator};
+        use crate::mutators::{
+            CustomMutator, GeneralizedFinishMutator, PeelMutator, finish_mutator,
+        };
+        use crate::objectives::{
+            CrashBucketFeedback, HangBucketFeedback, HangFilter, LatencyBudgetFeedback,
+        };
+        use crate::perf::{MaxCountFeedback, PerfBudgetFeedback};
+        use crate::sanitizer_coverage::{MAP_SIZE, SIGNALS_PTR};
+        use crate::stages::{
+            ChecksumStage, HavocStage, LatencyConfirmStage, LenControlStage, TrimStage,
+        };
+
+        unsafe {
+            if SIGNALS_PTR.is_null() {
+                crate::sanitizer_coverage::init_coverage();
+            }
+            let perf = $opts.fuzz_mode == crate::config::FuzzMode::Perf;
+            if perf {
+                crate::sanitizer_coverage::enable_perf_counts();
+            }
+
+            // Index tracking lets the minimizer scheduler see each entry's edges;
+            // novelty tracking tells Grimoire which edges an entry added.
+            let $observer = StdMapObserver::from_mut_ptr("signals", SIGNALS_PTR, MAP_SIZE);
+            let $observer = static_if!(
+                $indices,
+                libafl::observers::CanTrack::track_indices($observer),
+                $observer
+            );
+            let $observer = static_if!(
+                $novelties,
+                libafl::observers::CanTrack::track_novelties($observer),
+                $observer
+            );
+            let generalization = static_if!($novelties, GeneralizationStage::new(&$observer), ());
+            let time_observer = TimeObserver::new("time");
+            // Hashed in the crash handler to bucket crashes by call stack.
+            let backtrace_observer = BacktraceObserver::owned("backtrace", HarnessType::InProcess);
+
+            // Power schedules calibrate new entries and scale havoc energy.
+            let power = crate::schedulers::power_schedule($strategy.scheduler).is_some();
+            let map_feedback = MaxMapFeedback::new(&$observer);
+            let calibration = CalibrationStage::new(&map_feedback);
+
+            let exec_time =
+                ExecTimeFeedback::new(&time_observer, &$opts.slow_dir, $opts.slow_input_count);
+            let exec_times = exec_time.histogram();
+            let mut feedback = EagerOrFeedback::new(
+                EagerOrFeedback::new(map_feedback, MaxCountFeedback::new(perf)),
+                EagerOrFeedback::new(TimeFeedback::new(&time_observer), exec_time),
+            );
+            // Over-budget runs are confirmed by re-running them in the next round.
+            let latency_budget = LatencyBudgetFeedback::new(
+                &time_observer,
+                &$opts.slow_inputs_dir,
+                $opts.latency_budget_us,
+            );
+            let latency_confirm = LatencyConfirmStage::new(
+                latency_budget.pending(),
+                &$opts.slow_inputs_dir,
+                $opts.latency_budget_us,
+            );
+            // Only the first crash of each bucket is written to crash_dir. Hangs
+            // are bucketed by coverage and written to hang_dir by their feedback.
+            // PERF runs over the hit budget are objectives once per bucket.
+            let mut objective = EagerOrFeedback::new(
+                FastAndFeedback::new(
+                    CrashFeedback::new(),
+                    CrashBucketFeedback::new(&backtrace_observer, &$opts.crash_dir),
+                ),
+                EagerOrFeedback::new(
+                    HangBucketFeedback::new(&$opts.hang_dir),
+                    EagerOrFeedback::new(
+                        PerfBudgetFeedback::new(
+                            &$opts.perf_dir,
+                            if perf { $opts.perf_hit_budget } else { 0 },
+                        ),
+                        latency_budget,
+                    ),
+                ),
+            );
+
+            let mut $state = StdState::new(
+                StdRand::with_seed(current_nanos()),
+                InMemoryCorpus::new(),
+                OnDiskCorpus::new(PathBuf::from($opts.crash_dir.clone())).unwrap(),
+                &mut feedback,
+                &mut objective,
+            )
+            .unwrap();
+            $state.set_max_size($opts.max_input_len);
+
+            let scheduler = $make_scheduler;
+            let input_filter = RecentInputFilter::new($opts.input_cache_slots, $opts.string_input);
+            let input_cache = input_filter.is_enabled().then(|| input_filter.stats());
+            let mut fuzzer =
+                StdFuzzer::with_input_filter(scheduler, feedback, objective, input_filter);
+
+            // Inputs that already hung are rejected without running the target.
+            // The set is reloaded on restart, which every timeout triggers.
+            // Oversized inputs are rejected here too, whatever stage produced them.
+            // Rejected inputs still clear the maps, so feedbacks never see the
+            // coverage or PERF hit counts of the previous run.
+            let known_hangs = HangFilter::load(&$opts.hang_dir);
+            let max_input_len = $opts.max_input_len;
+            let mut guarded_harness = |input: &BytesInput| {
+                if known_hangs.contains(input) || input.len() > max_input_len {
+                    crate::sanitizer_coverage::reset_coverage();
+                    return libafl::executors::ExitKind::Ok;
+                }
+                ($harness)(input)
+            };
+
+            let mut executor = libafl::executors::inprocess::InProcessExecutor::with_timeout(
+                &mut guarded_harness,
+                tuple_list!($observer, time_observer, backtrace_observer),
+                &mut fuzzer,
+                &mut $state,
+                &mut $mgr,
+                $opts.timeout,
+            )
+            .unwrap();
+
+            if $state.corpus().count() == 0 {
+                let seed_sizes: [usize; 5] = [4, 16, 32, 64, 128];
+                let seeds_per_size = $opts.seed_count / seed_sizes.len();
+                let remainder = $opts.seed_count % seed_sizes.len();
+
+                for (i, &size) in seed_sizes.iter().enumerate() {
+                    let count = seeds_per_size + if i < remainder { 1 } else { 0 };
+                    if count > 0 {
+                        let mut generator = FixupGenerator::new(
+                            SeedGenerator::new(
+                                NonZero::new(size.min($opts.max_input_len).max(1)).unwrap(),
+                                $opts.string_input,
+                            ),
+                            $opts.fixup,
+                        );
+                        $state
+                            .generate_initial_inputs(
+                                &mut fuzzer,
+                                &mut executor,
+                                &mut generator,
+                                &mut $mgr,
+                                count,
+                            )
+                            .unwrap();
+                    }
+                }
+            }
+
+            let mutator = finish_mutator(
+                PeelMutator::select(
+                    $strategy.mutator,
+                    || HavocScheduledMutator::new(havoc_mutations()),
+                    || StdMOptMutator::new(&mut $state, havoc_mutations(), 7, 5).unwrap(),
+                ),
+                $opts.string_input,
+                $opts.fixup,
+            );
+            let havoc_stage = if power {
+                HavocStage::Power(StdPowerMutationalStage::new(mutator))
+            } else {
+                HavocStage::Plain(StdMutationalStage::new(mutator))
+            };
+            let custom_mutator = CustomMutator::new($opts.custom_mutator, $opts.custom_crossover);
+            let custom = custom_mutator.is_enabled();
+            let custom_mutator = finish_mutator(custom_mutator, $opts.string_input, $opts.fixup);
+            let checksum_repair = $opts.checksum_repair;
+            let grimoire = $opts.grimoire;
+            // Weighted towards deletion to keep recombined inputs from growing.
+            let grimoire_mutator = GeneralizedFinishMutator::new(
+                HavocScheduledMutator::with_max_stack_pow(
+                    tuple_list!(
+                        GrimoireExtensionMutator::new(),
+                        GrimoireRecursiveReplacementMutator::new(),
+                        GrimoireStringReplacementMutator::new(),
+                        GrimoireRandomDeleteMutator::new(),
+                        GrimoireRandomDeleteMutator::new(),
+                    ),
+                    3,
+                ),
+                $opts.string_input,
+                $opts.fixup,
+            );
+            let checksum_mutator = finish_mutator(
+                HavocScheduledMutator::new(havoc_mutations()),
+                $opts.string_input,
+                $opts.fixup,
+            );
+            let havoc = $opts.havoc_enabled();
+
+            // Latency confirmation runs first: a later stage failing ends the
+            // round, which must not leave queued inputs unconfirmed.
+            let mut stages = tuple_list!(
+                latency_confirm,
+                LenControlStage::new($opts.len_control, $opts.max_input_len),
+                TrimStage::new($opts.trim_pct, $opts.fixup),
+                IfStage::new(
+                    |_: &mut _, _: &mut _, _: &mut _, _: &mut _| -> Result<bool, Error> {
+                        Ok(power)
+                    },
+                    tuple_list!(calibration)
+                ),
+                IfStage::new(
+                    |_: &mut _, _: &mut _, _: &mut _, _: &mut _| -> Result<bool, Error> {
+                        Ok(havoc)
+                    },
+                    tuple_list!(havoc_stage)
+                ),
+                IfStage::new(
+                    |_: &mut _, _: &mut _, _: &mut _, _: &mut _| -> Result<bool, Error> {
+                        Ok(custom)
+                    },
+                    tuple_list!(StdMutationalStage::new(custom_mutator))
+                ),
+                IfStage::new(
+                    |_: &mut _, _: &mut _, _: &mut _, _: &mut _| -> Result<bool, Error> {
+                        Ok(checksum_repair)
+                    },
+                    tuple_list!(ChecksumStage::new(checksum_mutator))
+                ),
+                IfStage::new(
+                    |_: &mut _, _: &mut _, _: &mut _, _: &mut _| -> Result<bool, Error> {
+                        Ok(grimoire)
+                    },
+                    static_if!(
+                        $novelties,
+                        tuple_list!(
+                            generalization,
+                            StdMutationalStage::transforming(grimoire_mutator)
+                        ),
+                        {
+                            let _ = (generalization, grimoire_mutator);
+                            tuple_list!()
+                        }
+                    )
+                )
+            );
+
+            // Tag this client's stats with its strategy so the monitor shows which pays off.
+            $mgr.fire(
+                &mut $state,
+                Event::UpdateUserStats {
+                    name: Cow::Borrowed("strategy"),
+                    value: UserStats::new(
+                        UserStatsValue::String(Cow::Owned($strategy.to_string())),
+                        AggregatorOps::None,
+                    ),
+                    phantom: PhantomData,
+                },
+            )
+            .unwrap();
+
+            let deadline = std::time::Instant::now() + $opts.fuzz_duration;
+            let mut next_report = std::time::Instant::now();
+            #[cfg(feature = "introspection")]
+            let start_cycles = libafl_bolts::cpu::read_time_counter();
+            loop {
+                let now = std::time::Instant::now();
+                if now >= deadline || crate::session::stop_requested() {
+                    break;
+                }
+                if now >= next_report {
+                    next_report = now + crate::engine::STATS_REPORT_INTERVAL;
+                    exec_times.flush();
+                    if let Some(cache) = input_cache.as_ref() {
+                        let _ = $mgr.fire(
+                            &mut $state,
+                            Event::UpdateUserStats {
+                                name: Cow::Borrowed("input_cache_hits"),
+                                value: UserStats::new(
+                                    UserStatsValue::Ratio(cache.hits.get(), cache.lookups.get()),
+                                    AggregatorOps::Avg,
+                                ),
+                                phantom: PhantomData,
+                            },
+                        );
+                    }
+                    #[cfg(feature = "introspection")]
+                    let _ = $mgr.fire(
+                        &mut $state,
+                        crate::engine::reset_coverage_stats(start_cycles),
+                    );
+                }
+                let _ = fuzzer.fuzz_one(&mut stages, &mut executor, &mut $state, &mut $mgr);
+            }
+            crate::objectives::flush_buckets();
+        }
+    }};
+}
+
+#[cfg(feature = "std")]
+use fuzz_client;
+
+// ---------------------------------------------------------------------------
+// std: Multicore macro using LibAFL Launcher with fork-based parallelism.
+// ---------------------------------------------------------------------------
+//
+// `$client` is the per-client macro (`fuzz_client` or `grammar_client`) and
+// `$input` the input type it fuzzes with.
+#[cfg(feature = "std")]
+macro_rules! run_engine_multicore {
+    ($client:ident, $input:ty, $harness:expr, $monitor:expr, $opts:expr) => {{
+        use libafl::{
+            corpus::{InMemoryCorpus, OnDiskCorpus},
+            events::{EventConfig, launcher::Launcher},
+            state::StdState,
         };
         use libafl_bolts::{
             core_affinity::Cores,
-            current_nanos,
-            rands::StdRand,
             shmem::{ShMemProvider, StdShMemProvider},
-            tuples::tuple_list,
         };
 
-        use crate::sanitizer_coverage::{MAP_SIZE, SIGNALS_PTR};
+        use crate::strategy::Strategy;
+
+        // Shared stop flag, set by the broker's stop policy or a session handle.
+        crate::session::ensure_shared();
+        // Exec-time histogram the clients merge into and the broker reports.
+        crate::exec_time::ensure_shared();
 
-        let cores_str = format!("0-{}", $core_count - 1);
+        let opts = $opts.clone();
+        let cores_str = format!("0-{}", opts.core_count - 1);
         let cores = Cores::from_cmdline(&cores_str).unwrap();
         let shmem_provider = StdShMemProvider::new().unwrap();
 
-        let crash_dir = $crash_dir.clone();
-        let seed_count = $seed_count;
-        let timeout = $timeout;
-        let fuzz_duration = $fuzz_duration;
-
         let mut launcher = Launcher::builder()
             .shmem_provider(shmem_provider)
             .monitor($monitor)
             .configuration(EventConfig::AlwaysUnique)
             .cores(&cores)
-            .run_client(move |_state_opt, mut mgr, _client_desc| {
-                unsafe {
-                    if SIGNALS_PTR.is_null() {
-                        crate::sanitizer_coverage::init_coverage();
-                    }
-
-                    let $observer = StdMapObserver::from_mut_ptr("signals", SIGNALS_PTR, MAP_SIZE);
-                    let time_observer = TimeObserver::new("time");
-
-                    let mut feedback = EagerOrFeedback::new(
-                        MaxMapFeedback::new(&$observer),
-                        TimeFeedback::new(&time_observer),
-                    );
-                    let mut objective =
-                        EagerOrFeedback::new(CrashFeedback::new(), TimeoutFeedback::new());
-
-                    let mut $state = StdState::new(
-                        StdRand::with_seed(current_nanos()),
-                        InMemoryCorpus::new(),
-                        OnDiskCorpus::new(PathBuf::from(crash_dir.clone())).unwrap(),
-                        &mut feedback,
-                        &mut objective,
-                    )
-                    .unwrap();
-
-                    let scheduler = $make_scheduler;
-                    let mut fuzzer = StdFuzzer::new(scheduler, feedback, objective);
+            .run_client(move |_state_opt, mut mgr, client_desc| {
+                let strategy = opts.strategy_plan.strategy_for(
+                    client_desc.id(),
+                    Strategy {
+                        scheduler: opts.scheduler_type,
+                        mutator: opts.mutator_type,
+                    },
+                );
 
-                    let mut executor =
-                        libafl::executors::inprocess::InProcessExecutor::with_timeout(
-                            &mut $harness,
-                            tuple_list!($observer, time_observer),
-                            &mut fuzzer,
-                            &mut $state,
-                            &mut mgr,
-                            timeout,
-                        )
-                        .unwrap();
-
-                    if $state.corpus().count() == 0 {
-                        let seed_sizes: [usize; 5] = [4, 16, 32, 64, 128];
-                        let seeds_per_size = seed_count / seed_sizes.len();
-                        let remainder = seed_count % seed_sizes.len();
-
-                        for (i, &size) in seed_sizes.iter().enumerate() {
-                            let count = seeds_per_size + if i < remainder { 1 } else { 0 };
-                            if count > 0 {
-                                let mut generator =
-                                    RandBytesGenerator::new(NonZero::new(size).unwrap());
-                                $state
-                                    .generate_initial_inputs(
-                                        &mut fuzzer,
-                                        &mut executor,
-                                        &mut generator,
-                                        &mut mgr,
-                                        count,
-                                    )
-                                    .unwrap();
-                            }
-                        }
+                match strategy.scheduler {
+                    crate::config::SchedulerType::Queue => {
+                        $client!($harness, mgr, opts, strategy, false, |_s, _o| {
+                            libafl::schedulers::QueueScheduler::new()
+                        });
                     }
-
-                    let mutator = HavocScheduledMutator::new(havoc_mutations());
-                    let mut stages = tuple_list!(StdMutationalStage::new(mutator));
-
-                    let deadline = std::time::Instant::now() + fuzz_duration;
-                    loop {
-                        if std::time::Instant::now() >= deadline {
-                            break;
-                        }
-                        let _ = fuzzer.fuzz_one(&mut stages, &mut executor, &mut $state, &mut mgr);
+                    crate::config::SchedulerType::Weighted => {
+                        $client!($harness, mgr, opts, strategy, false, |state, observer| {
+                            crate::schedulers::StdWeightedScheduler::new(&mut state, &observer)
+                        });
+                    }
+                    crate::config::SchedulerType::Minimized => {
+                        $client!($harness, mgr, opts, strategy, true, |_s, observer| {
+                            crate::schedulers::IndexesLenTimeMinimizerScheduler::new(
+                                &observer,
+                                libafl::schedulers::QueueScheduler::new(),
+                            )
+                        });
+                    }
+                    power => {
+                        let schedule = crate::schedulers::power_schedule(power);
+                        $client!($harness, mgr, opts, strategy, false, |state, observer| {
+                            crate::schedulers::StdWeightedScheduler::with_schedule(
+                                &mut state, &observer, schedule,
+                            )
+                        });
                     }
                 }
 
@@ -282,51 +899,71 @@ macro_rules! run_engine_multicore {
             .build();
 
         launcher
-            .launch::<BytesInput, StdState<
-                InMemoryCorpus<BytesInput>,
-                BytesInput,
+            .launch::<$input, StdState<
+                InMemoryCorpus<$input>,
+                $input,
                 libafl_bolts::rands::StdRand,
-                OnDiskCorpus<BytesInput>,
+                OnDiskCorpus<$input>,
             >>()
             .expect("Failed to launch multicore fuzzer");
+
+        // Fresh blocks per run: a stop from this run must not end the next.
+        crate::exec_time::release_shared();
+        crate::session::release_shared();
     }};
 }
 
 #[cfg(feature = "std")]
-use run_engine_multicore;
+pub(crate) use run_engine_multicore;
 
 // ---------------------------------------------------------------------------
 // no_std: Single-core macro — no fork, no filesystem, no clock.
 // ---------------------------------------------------------------------------
 #[cfg(not(feature = "std"))]
 macro_rules! run_engine_singlecore {
-    ($harness:expr, $monitor:expr, $seed_count:expr,
+    ($harness:expr, $monitor:expr, $opts:expr, $indices:tt,
      |$state:ident, $observer:ident| $make_scheduler:expr) => {{
         use core::num::NonZero;
 
         use libafl::{
+            Error,
             corpus::{Corpus, InMemoryCorpus},
             events::SimpleEventManager,
             feedbacks::{CrashFeedback, MaxMapFeedback},
             fuzzer::{Fuzzer, StdFuzzer},
-            generators::RandBytesGenerator,
-            mutators::{havoc_mutations::havoc_mutations, scheduled::HavocScheduledMutator},
+            mutators::{
+                StdMOptMutator, havoc_mutations::havoc_mutations, scheduled::HavocScheduledMutator,
+            },
             observers::StdMapObserver,
-            stages::mutational::StdMutationalStage,
-            state::{HasCorpus, StdState},
+            stages::{IfStage, mutational::StdMutationalStage},
+            state::{HasCorpus, HasMaxSize, StdState},
         };
         use libafl_bolts::{current_nanos, rands::StdRand, tuples::tuple_list};
 
+        use crate::dedup::RecentInputFilter;
+        use crate::generators::{FixupGenerator, SeedGenerator};
+        use crate::mutators::{CustomMutator, finish_mutator};
         use crate::sanitizer_coverage::{MAP_SIZE, SIGNALS_PTR};
 
-        let seed_count = $seed_count;
+        let seed_count = $opts.seed_count;
+        let mutator_type = $opts.mutator_type;
+        let havoc = $opts.havoc_enabled();
+        let fixup = $opts.fixup;
+        let string_input = $opts.string_input;
+        let max_input_len = $opts.max_input_len;
 
         unsafe {
             if SIGNALS_PTR.is_null() {
                 crate::sanitizer_coverage::init_coverage();
             }
 
+            // Index tracking only for the minimizer scheduler.
             let $observer = StdMapObserver::from_mut_ptr("signals", SIGNALS_PTR, MAP_SIZE);
+            let $observer = static_if!(
+                $indices,
+                libafl::observers::CanTrack::track_indices($observer),
+                $observer
+            );
 
             let mut feedback = MaxMapFeedback::new(&$observer);
             let mut objective = CrashFeedback::new();
@@ -339,9 +976,12 @@ macro_rules! run_engine_singlecore {
                 &mut objective,
             )
             .unwrap();
+            $state.set_max_size(max_input_len);
 
             let scheduler = $make_scheduler;
-            let mut fuzzer = StdFuzzer::new(scheduler, feedback, objective);
+            let input_filter = RecentInputFilter::new($opts.input_cache_slots, string_input);
+            let mut fuzzer =
+                StdFuzzer::with_input_filter(scheduler, feedback, objective, input_filter);
 
             let mut mgr = SimpleEventManager::new($monitor);
 
@@ -362,7 +1002,13 @@ macro_rules! run_engine_singlecore {
                 for (i, &size) in seed_sizes.iter().enumerate() {
                     let count = seeds_per_size + if i < remainder { 1 } else { 0 };
                     if count > 0 {
-                        let mut generator = RandBytesGenerator::new(NonZero::new(size).unwrap());
+                        let mut generator = FixupGenerator::new(
+                            SeedGenerator::new(
+                                NonZero::new(size.min(max_input_len).max(1)).unwrap(),
+                                string_input,
+                            ),
+                            fixup,
+                        );
                         $state
                             .generate_initial_inputs(
                                 &mut fuzzer,
@@ -376,8 +1022,32 @@ macro_rules! run_engine_singlecore {
                 }
             }
 
-            let mutator = HavocScheduledMutator::new(havoc_mutations());
-            let mut stages = tuple_list!(StdMutationalStage::new(mutator));
+            let mutator = finish_mutator(
+                crate::mutators::PeelMutator::select(
+                    mutator_type,
+                    || HavocScheduledMutator::new(havoc_mutations()),
+                    || StdMOptMutator::new(&mut $state, havoc_mutations(), 7, 5).unwrap(),
+                ),
+                string_input,
+                fixup,
+            );
+            let custom_mutator = CustomMutator::new($opts.custom_mutator, $opts.custom_crossover);
+            let custom = custom_mutator.is_enabled();
+            let custom_mutator = finish_mutator(custom_mutator, string_input, fixup);
+            let mut stages = tuple_list!(
+                IfStage::new(
+                    |_: &mut _, _: &mut _, _: &mut _, _: &mut _| -> Result<bool, Error> {
+                        Ok(havoc)
+                    },
+                    tuple_list!(StdMutationalStage::new(mutator))
+                ),
+                IfStage::new(
+                    |_: &mut _, _: &mut _, _: &mut _, _: &mut _| -> Result<bool, Error> {
+                        Ok(custom)
+                    },
+                    tuple_list!(StdMutationalStage::new(custom_mutator))
+                )
+            );
 
             // Runs forever — the host / debugger / watchdog terminates externally.
             fuzzer
@@ -0,0 +1,357 @@
+/// Exec-time histograms and slow-input reporting.
+///
+/// Each client records every run's `TimeObserver` duration into a local
+/// log-linear histogram (HDR-style: 16 sub-buckets per power of two, so a
+/// value is never more than ~6% above its bucket's lower bound). Every
+/// `STATS_REPORT_INTERVAL` the client adds what it gathered since the last
+/// flush into a merged histogram in shared memory, which the broker reads for
+/// p50/p99/p999. Runs themselves only bump a local counter.
+///
+/// Optionally, corpus entries among the N slowest seen by any client are
+/// written to a slow directory as `<micros>us-<hash>`; the directory is
+/// pruned back to the N slowest after each write.
+use std::borrow::Cow;
+use std::cell::Cell;
+use std::fs;
+use std::path::PathBuf;
+use std::ptr;
+use std::rc::Rc;
+use std::sync::atomic::{AtomicPtr, AtomicU64, Ordering};
+
+use libafl::Error;
+use libafl::corpus::Testcase;
+use libafl::executors::ExitKind;
+use libafl::feedbacks::{Feedback, StateInitializer};
+use libafl::inputs::HasTargetBytes;
+use libafl::observers::TimeObserver;
+use libafl_bolts::tuples::{Handle, Handled, MatchName, MatchNameRef};
+use libafl_bolts::{AsSlice, Named, hash_std};
+
+const SUB_BITS: u32 = 4;
+const SUB_BUCKETS: usize = 1 << SUB_BITS;
+/// Enough buckets for any `u64` microsecond value.
+pub const BUCKETS: usize = (64 - SUB_BITS as usize + 1) * SUB_BUCKETS;
+
+/// Bucket of a duration in microseconds.
+#[inline]
+fn bucket(micros: u64) -> usize {
+    if micros < SUB_BUCKETS as u64 {
+        return micros as usize;
+    }
+    let shift = 63 - micros.leading_zeros() - SUB_BITS;
+    let sub = (micros >> shift) as usize & (SUB_BUCKETS - 1);
+    (shift as usize + 1) * SUB_BUCKETS + sub
+}
+
+/// Smallest duration, in microseconds, that falls into bucket `index`.
+pub fn bucket_floor(index: usize) -> u64 {
+    if index < SUB_BUCKETS {
+        return index as u64;
+    }
+    let shift = index / SUB_BUCKETS - 1;
+    ((SUB_BUCKETS + index % SUB_BUCKETS) as u64) << shift
+}
+
+/// Histogram merged over all clients, shared with the broker.
+struct SharedHistogram {
+    counts: [AtomicU64; BUCKETS],
+    sum_micros: AtomicU64,
+}
+
+static SHARED: AtomicPtr<SharedHistogram> = AtomicPtr::new(ptr::null_mut());
+
+/// Map a zeroed merged histogram for this run. Must be called before the
+/// launcher forks, and paired with `release_shared` once the launch returns.
+pub fn ensure_shared() {
+    if SHARED.load(Ordering::Relaxed).is_null() {
+        if let Some(shared) = crate::session::map_shared::<SharedHistogram>() {
+            SHARED.store(shared, Ordering::Relaxed);
+        }
+    }
+}
+
+/// Unmap the merged histogram, so the next run in this process starts empty.
+pub fn release_shared() {
+    crate::session::unmap_shared(SHARED.swap(ptr::null_mut(), Ordering::Relaxed));
+}
+
+/// One client's runs since its last flush.
+pub struct LocalHistogram {
+    counts: Box<[Cell<u64>]>,
+    sum_micros: Cell<u64>,
+}
+
+impl Default for LocalHistogram {
+    fn default() -> Self {
+        Self {
+            counts: (0..BUCKETS).map(|_| Cell::new(0)).collect(),
+            sum_micros: Cell::new(0),
+        }
+    }
+}
+
+impl LocalHistogram {
+    #[inline]
+    fn record(&self, micros: u64) {
+        let count = &self.counts[bucket(micros)];
+        count.set(count.get() + 1);
+        self.sum_micros.set(self.sum_micros.get() + micros);
+    }
+
+    /// Add the local counts to the merged histogram and start over.
+    pub fn flush(&self) {
+        let shared = SHARED.load(Ordering::Relaxed);
+        if shared.is_null() {
+            return;
+        }
+        let shared = unsafe { &*shared };
+        for (local, merged) in self.counts.iter().zip(&shared.counts) {
+            let n = local.replace(0);
+            if n != 0 {
+                merged.fetch_add(n, Ordering::Relaxed);
+            }
+        }
+        shared
+            .sum_micros
+            .fetch_add(self.sum_micros.replace(0), Ordering::Relaxed);
+    }
+}
+
+/// Copy of the merged histogram, taken by the broker.
+pub struct ExecTimes {
+    pub counts: Vec<u64>,
+    pub total: u64,
+    pub sum_micros: u64,
+}
+
+impl ExecTimes {
+    /// Snapshot of the merged histogram; None before any client flushed.
+    pub fn merged() -> Option<Self> {
+        let shared = SHARED.load(Ordering::Relaxed);
+        if shared.is_null() {
+            return None;
+        }
+        let shared = unsafe { &*shared };
+        let counts: Vec<u64> = shared
+            .counts
+            .iter()
+            .map(|c| c.load(Ordering::Relaxed))
+            .collect();
+        let total = counts.iter().sum();
+        (total > 0).then(|| Self {
+            counts,
+            total,
+            sum_micros: shared.sum_micros.load(Ordering::Relaxed),
+        })
+    }
+
+    /// Exec time in microseconds below which a `q` share of runs fall, to
+    /// bucket precision.
+    pub fn percentile(&self, q: f64) -> u64 {
+        let rank = ((q * self.total as f64).ceil() as u64).max(1);
+        let mut seen = 0;
+        for (index, &count) in self.counts.iter().enumerate() {
+            seen += count;
+            if seen >= rank {
+                return bucket_floor(index);
+            }
+        }
+        bucket_floor(BUCKETS - 1)
+    }
+
+    /// Runs that took at most `micros`. Exact when `micros + 1` is a bucket
+    /// boundary, e.g. one below a power of two.
+    pub fn count_at_most(&self, micros: u64) -> u64 {
+        match micros.checked_add(1) {
+            Some(limit) => self.counts[..bucket(limit)].iter().sum(),
+            None => self.total,
+        }
+    }
+}
+
+/// Records every run's duration into a `LocalHistogram` and, with a slow
+/// directory, writes the slowest corpus entries there. Never interesting on
+/// its own.
+pub struct ExecTimeFeedback {
+    time: Handle<TimeObserver>,
+    histogram: Rc<LocalHistogram>,
+    last_micros: u64,
+    slow: Option<SlowInputs>,
+}
+
+impl ExecTimeFeedback {
+    pub fn new(time: &TimeObserver, slow_dir: &str, slow_count: usize) -> Self {
+        Self {
+            time: time.handle(),
+            histogram: Rc::default(),
+            last_micros: 0,
+            slow: (slow_count > 0).then(|| SlowInputs::new(slow_dir, slow_count)),
+        }
+    }
+
+    /// Handle to the histogram, which stays valid after the feedback moves
+    /// into the fuzzer.
+    pub fn histogram(&self) -> Rc<LocalHistogram> {
+        Rc::clone(&self.histogram)
+    }
+}
+
+impl Named for ExecTimeFeedback {
+    fn name(&self) -> &Cow<'static, str> {
+        static NAME: Cow<'static, str> = Cow::Borrowed("ExecTimeFeedback");
+        &NAME
+    }
+}
+
+impl<S> StateInitializer<S> for ExecTimeFeedback {}
+
+impl<EM, I, OT, S> Feedback<EM, I, OT, S> for ExecTimeFeedback
+where
+    I: HasTargetBytes,
+    OT: MatchName,
+{
+    fn is_interesting(
+        &mut self,
+        _state: &mut S,
+        _manager: &mut EM,
+        _input: &I,
+        observers: &OT,
+        _exit_kind: &ExitKind,
+    ) -> Result<bool, Error> {
+        if let Some(runtime) = observers.get(&self.time).and_then(|o| *o.last_runtime()) {
+            self.last_micros = runtime.as_micros() as u64;
+            self.histogram.record(self.last_micros);
+        }
+        Ok(false)
+    }
+
+    /// Runs for inputs entering the corpus, right after `is_interesting`.
+    fn append_metadata(
+        &mut self,
+        _state: &mut S,
+        _manager: &mut EM,
+        _observers: &OT,
+        testcase: &mut Testcase<I>,
+    ) -> Result<(), Error> {
+        if let (Some(slow), Some(input)) = (&mut self.slow, testcase.input()) {
+            slow.offer(self.last_micros, input.target_bytes().as_slice());
+        }
+        Ok(())
+    }
+}
+
+/// The N slowest corpus entries, kept on disk so every client shares them.
+struct SlowInputs {
+    dir: PathBuf,
+    count: usize,
+    /// Entries no slower than this cannot make the list; updated on each prune.
+    floor_micros: u64,
+}
+
+impl SlowInputs {
+    fn new(dir: &str, count: usize) -> Self {
+        let dir = PathBuf::from(dir);
+        let _ = fs::create_dir_all(&dir);
+        Self {
+            dir,
+            count,
+            floor_micros: 0,
+        }
+    }
+
+    fn offer(&mut self, micros: u64, bytes: &[u8]) {
+        if micros <= self.floor_micros {
+            return;
+        }
+        // Zero-padded so names sort by exec time.
+        let name = format!("{micros:012}us-{:016x}", hash_std(bytes));
+        let _ = fs::write(self.dir.join(name), bytes);
+
+        let Ok(entries) = fs::read_dir(&self.dir) else {
+            return;
+        };
+        let mut names: Vec<String> = entries
+            .filter_map(|entry| entry.ok()?.file_name().into_string().ok())
+            .filter(|name| !name.starts_with('.'))
+            .collect();
+        names.sort_unstable();
+        let excess = names.len().saturating_sub(self.count);
+        for name in &names[..excess] {
+            let _ = fs::remove_file(self.dir.join(name));
+        }
+        if names.len() >= self.count {
+            self.floor_micros = names[excess]
+                .split("us-")
+                .next()
+                .and_then(|m| m.parse().ok())
+                .unwrap_or(0);
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn exec_times(micros: &[(u64, u64)]) -> ExecTimes {
+        let mut counts = vec![0; BUCKETS];
+        let (mut total, mut sum_micros) = (0, 0);
+        for &(value, n) in micros {
+            counts[bucket(value)] += n;
+            total += n;
+            sum_micros += value * n;
+        }
+        ExecTimes {
+            counts,
+            total,
+            sum_micros,
+        }
+    }
+
+    #[test]
+    fn small_values_are_exact() {
+        for micros in 0..SUB_BUCKETS as u64 * 2 {
+            assert_eq!(bucket_floor(bucket(micros)), micros);
+        }
+    }
+
+    #[test]
+    fn buckets_cover_u64() {
+        assert_eq!(bucket(u64::MAX), BUCKETS - 1);
+        for index in 1..BUCKETS {
+            assert!(bucket_floor(index - 1) < bucket_floor(index));
+            assert_eq!(bucket(bucket_floor(index)), index);
+            assert_eq!(bucket(bucket_floor(index) - 1), index - 1);
+        }
+    }
+
+    #[test]
+    fn bucket_floor_within_precision() {
+        let mut micros = 1u64;
+        while micros < u64::MAX / 3 {
+            let floor = bucket_floor(bucket(micros));
+            assert!(floor <= micros);
+            assert!(micros - floor <= micros / SUB_BUCKETS as u64, "{micros}");
+            micros = micros * 3 + 1;
+        }
+    }
+
+    #[test]
+    fn percentiles() {
+        let times = exec_times(&[(10, 500), (1000, 495), (100_000, 5)]);
+        assert_eq!(times.percentile(0.0), 10);
+        assert_eq!(times.percentile(0.5), 10);
+        assert_eq!(times.percentile(0.99), bucket_floor(bucket(1000)));
+        assert_eq!(times.percentile(0.999), bucket_floor(bucket(100_000)));
+        assert_eq!(times.percentile(1.0), bucket_floor(bucket(100_000)));
+    }
+
+    #[test]
+    fn count_at_most_is_exact_below_powers_of_two() {
+        let times = exec_times(&[(1000, 1), (1023, 2), (1024, 4), (2047, 8), (2048, 16)]);
+        assert_eq!(times.count_at_most(1023), 3);
+        assert_eq!(times.count_at_most(2047), 15);
+        assert_eq!(times.count_at_most(u64::MAX), 31);
+        assert_eq!(times.count_at_most(0), 0);
+    }
+}
@@ -0,0 +1,63 @@
+/// Seed generators used to populate an empty corpus.
+use core::num::NonZero;
+
+use libafl::Error;
+use libafl::generators::{Generator, RandBytesGenerator, RandPrintablesGenerator};
+use libafl::inputs::{BytesInput, HasMutatorBytes};
+use libafl::state::HasRand;
+
+use crate::mutators::apply_fixup;
+use crate::targets::CFixupFn;
+
+/// Runs the user's fixup over every generated seed, so initial inputs already
+/// carry valid checksums and length fields.
+pub struct FixupGenerator<G> {
+    inner: G,
+    fixup: Option<CFixupFn>,
+}
+
+impl<G> FixupGenerator<G> {
+    pub fn new(inner: G, fixup: Option<CFixupFn>) -> Self {
+        Self { inner, fixup }
+    }
+}
+
+impl<G, S> Generator<BytesInput, S> for FixupGenerator<G>
+where
+    G: Generator<BytesInput, S>,
+{
+    fn generate(&mut self, state: &mut S) -> Result<BytesInput, Error> {
+        let mut input = self.inner.generate(state)?;
+        apply_fixup(self.fixup, input.mutator_bytes_mut());
+        Ok(input)
+    }
+}
+
+/// Random seeds of up to `max_size` bytes: arbitrary bytes, or printable ASCII
+/// (valid UTF-8 without NULs) for string targets.
+pub enum SeedGenerator {
+    Bytes(RandBytesGenerator),
+    Printable(RandPrintablesGenerator),
+}
+
+impl SeedGenerator {
+    pub fn new(max_size: NonZero<usize>, printable: bool) -> Self {
+        if printable {
+            Self::Printable(RandPrintablesGenerator::new(max_size))
+        } else {
+            Self::Bytes(RandBytesGenerator::new(max_size))
+        }
+    }
+}
+
+impl<S> Generator<BytesInput, S> for SeedGenerator
+where
+    S: HasRand,
+{
+    fn generate(&mut self, state: &mut S) -> Result<BytesInput, Error> {
+        match self {
+            Self::Bytes(g) => g.generate(state),
+            Self::Printable(g) => g.generate(state),
+        }
+    }
+}
@@ -0,0 +1,355 @@
+/// Grammar-based fuzzing (`HARNESS_GRAMMAR`) on top of LibAFL's Nautilus.
+///
+/// Inputs are derivation trees of a context-free grammar. They are generated
+/// and mutated as trees and unparsed to bytes right before the byte target
+/// runs, so nearly every execution gets past the target's lexer and parser.
+///
+/// Rules are `(nonterminal, expansion)` pairs. Expansions reference other
+/// nonterminals as `{NAME}`, and the first rule's nonterminal is the start
+/// symbol. A grammar file is a JSON list of such pairs, e.g.
+/// `[["Expr", "{Expr}+{Expr}"], ["Expr", "1"]]`.
+use std::borrow::Cow;
+use std::ffi::CStr;
+use std::path::PathBuf;
+
+use libafl::Error;
+use libafl::executors::ExitKind;
+use libafl::feedbacks::{Feedback, StateInitializer};
+use libafl::generators::NautilusContext;
+use libafl::inputs::NautilusInput;
+use libafl_bolts::Named;
+
+use crate::config::PeelFuzzConfig;
+use crate::engine::{PeelFuzzer, run_engine_multicore};
+use crate::objectives::record_hang;
+use crate::targets::CTargetFn;
+
+/// Maximum derivation tree depth for generated inputs.
+const GRAMMAR_TREE_DEPTH: usize = 15;
+
+/// Byte target plus the grammar its inputs are derived from.
+pub struct GrammarTarget {
+    pub target_fn: CTargetFn,
+    pub context: NautilusContext,
+}
+
+impl GrammarTarget {
+    /// Load the grammar named by the config: `grammar_rules` if given,
+    /// otherwise the JSON file at `grammar_file`.
+    pub unsafe fn from_config(target_fn: CTargetFn, cfg: &PeelFuzzConfig) -> Self {
+        let context = if !cfg.grammar_rules.is_null() && cfg.grammar_rule_count > 0 {
+            let raw = unsafe {
+                core::slice::from_raw_parts(cfg.grammar_rules, cfg.grammar_rule_count as usize)
+            };
+            let owned: Vec<[String; 2]> = raw
+                .iter()
+                .map(|rule| unsafe {
+                    [
+                        CStr::from_ptr(rule.nonterm.cast())
+                            .to_string_lossy()
+                            .into_owned(),
+                        CStr::from_ptr(rule.expansion.cast())
+                            .to_string_lossy()
+                            .into_owned(),
+                    ]
+                })
+                .collect();
+            let rules: Vec<Vec<&str>> = owned
+                .iter()
+                .map(|[nonterm, expansion]| vec![nonterm.as_str(), expansion.as_str()])
+                .collect();
+            NautilusContext::new(GRAMMAR_TREE_DEPTH, &rules)
+        } else if !cfg.grammar_file.is_null() {
+            let path = unsafe { CStr::from_ptr(cfg.grammar_file.cast()) }
+                .to_string_lossy()
+                .into_owned();
+            NautilusContext::from_file(GRAMMAR_TREE_DEPTH, &path).expect("Failed to load grammar")
+        } else {
+            panic!("HARNESS_GRAMMAR requires grammar_file or grammar_rules");
+        };
+
+        Self { target_fn, context }
+    }
+}
+
+/// `HangBucketFeedback` for derivation trees: hanging inputs are unparsed and
+/// the bytes the target actually received go to the hang directory.
+///
+/// Always returns false, so hangs never land in `crash_dir`.
+pub struct GrammarHangFeedback<'a> {
+    context: &'a NautilusContext,
+    dir: PathBuf,
+    bytes: Vec<u8>,
+}
+
+impl<'a> GrammarHangFeedback<'a> {
+    pub fn new(context: &'a NautilusContext, dir: &str) -> Self {
+        Self {
+            context,
+            dir: PathBuf::from(dir),
+            bytes: Vec::new(),
+        }
+    }
+}
+
+impl Named for GrammarHangFeedback<'_> {
+    fn name(&self) -> &Cow<'static, str> {
+        static NAME: Cow<'static, str> = Cow::Borrowed("GrammarHangFeedback");
+        &NAME
+    }
+}
+
+impl<S> StateInitializer<S> for GrammarHangFeedback<'_> {}
+
+impl<EM, OT, S> Feedback<EM, NautilusInput, OT, S> for GrammarHangFeedback<'_> {
+    fn is_interesting(
+        &mut self,
+        _state: &mut S,
+        _manager: &mut EM,
+        input: &NautilusInput,
+        _observers: &OT,
+        exit_kind: &ExitKind,
+    ) -> Result<bool, Error> {
+        if *exit_kind != ExitKind::Timeout {
+            return Ok(false);
+        }
+
+        self.bytes.clear();
+        input.unparse(self.context, &mut self.bytes);
+        record_hang(&self.dir, &self.bytes);
+        Ok(false)
+    }
+}
+
+impl PeelFuzzer<GrammarTarget> {
+    /// Run the grammar fuzzer (multicore, fork-based).
+    ///
+    /// Byte-level options (trimming, custom mutators, fixup, checksum repair)
+    /// do not apply to derivation trees and are ignored.
+    pub unsafe fn run_grammar(self) {
+        let PeelFuzzer { harness, opts } = self;
+
+        let mon = crate::monitors::multi_monitor(&opts);
+        run_engine_multicore!(
+            grammar_client,
+            libafl::inputs::NautilusInput,
+            harness,
+            mon,
+            opts
+        );
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Per-client fuzzing loop over Nautilus derivation trees.
+// ---------------------------------------------------------------------------
+macro_rules! grammar_client {
+    ($grammar:expr, $mgr:ident, $opts:expr, $strategy:expr, $indices:tt,
+     |$state:ident, $observer:ident| $make_scheduler:expr) => {{
+        use core::marker::PhantomData;
+        use std::borrow::Cow;
+        use std::path::PathBuf;
+
+        use libafl::{
+            Error, HasMetadata,
+            corpus::{Corpus, InMemoryCorpus, OnDiskCorpus},
+            events::{Event, EventFirer},
+            executors::ExitKind,
+            feedbacks::{
+                CrashFeedback, EagerOrFeedback, FastAndFeedback, MaxMapFeedback,
+                NautilusChunksMetadata, NautilusFeedback, TimeFeedback,
+            },
+            fuzzer::{Fuzzer, StdFuzzer},
+            generators::NautilusGenerator,
+            inputs::NautilusInput,
+            mutators::{
+                NautilusRandomMutator, NautilusRecursionMutator, NautilusSpliceMutator,
+                StdMOptMutator, scheduled::HavocScheduledMutator,
+            },
+            observers::{BacktraceObserver, HarnessType, StdMapObserver, TimeObserver},
+            stages::{
+                CalibrationStage, IfStage, StdPowerMutationalStage, mutational::StdMutationalStage,
+            },
+            state::{HasCorpus, StdState},
+            statistics::user_stats::{AggregatorOps, UserStats, UserStatsValue},
+        };
+        use libafl_bolts::{current_nanos, rands::StdRand, tuples::tuple_list};
+
+        use crate::grammar::GrammarHangFeedback;
+        use crate::mutators::PeelMutator;
+        use crate::objectives::CrashBucketFeedback;
+        use crate::sanitizer_coverage::{MAP_SIZE, SIGNALS_PTR, reset_coverage};
+
+        unsafe {
+            if SIGNALS_PTR.is_null() {
+                crate::sanitizer_coverage::init_coverage();
+            }
+
+            let context = &$grammar.context;
+            let target_fn = $grammar.target_fn;
+
+            // Index tracking only for the minimizer scheduler.
+            let $observer = StdMapObserver::from_mut_ptr("signals", SIGNALS_PTR, MAP_SIZE);
+            let $observer = crate::engine::static_if!(
+                $indices,
+                libafl::observers::CanTrack::track_indices($observer),
+                $observer
+            );
+            let time_observer = TimeObserver::new("time");
+            let backtrace_observer = BacktraceObserver::owned("backtrace", HarnessType::InProcess);
+
+            let power = crate::schedulers::power_schedule($strategy.scheduler).is_some();
+            let map_feedback = MaxMapFeedback::new(&$observer);
+            let calibration = CalibrationStage::new(&map_feedback);
+
+            // NautilusFeedback records subtrees of new entries for the splice mutator.
+            let mut feedback = EagerOrFeedback::new(
+                EagerOrFeedback::new(map_feedback, TimeFeedback::new(&time_observer)),
+                NautilusFeedback::new(context),
+            );
+            // As for byte targets: the first crash of each bucket goes to
+            // crash_dir, hangs go to hang_dir as the bytes the target saw.
+            let mut objective = EagerOrFeedback::new(
+                FastAndFeedback::new(
+                    CrashFeedback::new(),
+                    CrashBucketFeedback::new(&backtrace_observer, &$opts.crash_dir),
+                ),
+                GrammarHangFeedback::new(context, &$opts.hang_dir),
+            );
+
+            let mut $state = StdState::new(
+                StdRand::with_seed(current_nanos()),
+                InMemoryCorpus::new(),
+                OnDiskCorpus::new(PathBuf::from($opts.crash_dir.clone())).unwrap(),
+                &mut feedback,
+                &mut objective,
+            )
+            .unwrap();
+            // The chunk store only needs a scratch directory; keep it out of
+            // crash_dir so the solutions stay the only files there. One per
+            // client process, so clients and concurrent runs never share it.
+            if !$state.has_metadata::<NautilusChunksMetadata>() {
+                let work_dir =
+                    std::env::temp_dir().join(format!("peelfuzz-nautilus-{}", std::process::id()));
+                $state.add_metadata(NautilusChunksMetadata::new(
+                    work_dir.to_string_lossy().into_owned(),
+                ));
+            }
+
+            let scheduler = $make_scheduler;
+            let mut fuzzer = StdFuzzer::new(scheduler, feedback, objective);
+
+            // Unparse into one reused buffer, then run the byte target.
+            let mut bytes = Vec::new();
+            let mut harness = |input: &NautilusInput| {
+                bytes.clear();
+                input.unparse(context, &mut bytes);
+                reset_coverage();
+                target_fn(bytes.as_ptr(), bytes.len());
+                ExitKind::Ok
+            };
+
+            let mut executor = libafl::executors::inprocess::InProcessExecutor::with_timeout(
+                &mut harness,
+                tuple_list!($observer, time_observer, backtrace_observer),
+                &mut fuzzer,
+                &mut $state,
+                &mut $mgr,
+                $opts.timeout,
+            )
+            .unwrap();
+
+            if $state.corpus().count() == 0 {
+                // Distinct derivations often share coverage, so keep every seed.
+                let mut generator = NautilusGenerator::new(context);
+                $state
+                    .generate_initial_inputs_forced(
+                        &mut fuzzer,
+                        &mut executor,
+                        &mut generator,
+                        &mut $mgr,
+                        $opts.seed_count,
+                    )
+                    .unwrap();
+            }
+
+            let tree_mutations = || {
+                tuple_list!(
+                    NautilusRandomMutator::new(context),
+                    NautilusRandomMutator::new(context),
+                    NautilusRecursionMutator::new(context),
+                    NautilusSpliceMutator::new(context),
+                    NautilusSpliceMutator::new(context),
+                )
+            };
+            let make_mutator = |state: &mut _| {
+                PeelMutator::select(
+                    $strategy.mutator,
+                    || HavocScheduledMutator::with_max_stack_pow(tree_mutations(), 2),
+                    || StdMOptMutator::new(state, tree_mutations(), 7, 5).unwrap(),
+                )
+            };
+            let mutator = make_mutator(&mut $state);
+            let power_mutator = make_mutator(&mut $state);
+
+            let mut stages = tuple_list!(
+                IfStage::new(
+                    |_: &mut _, _: &mut _, _: &mut _, _: &mut _| -> Result<bool, Error> {
+                        Ok(power)
+                    },
+                    tuple_list!(calibration)
+                ),
+                IfStage::new(
+                    |_: &mut _, _: &mut _, _: &mut _, _: &mut _| -> Result<bool, Error> {
+                        Ok(!power)
+                    },
+                    tuple_list!(StdMutationalStage::new(mutator))
+                ),
+                IfStage::new(
+                    |_: &mut _, _: &mut _, _: &mut _, _: &mut _| -> Result<bool, Error> {
+                        Ok(power)
+                    },
+                    tuple_list!(StdPowerMutationalStage::new(power_mutator))
+                )
+            );
+
+            $mgr.fire(
+                &mut $state,
+                Event::UpdateUserStats {
+                    name: Cow::Borrowed("strategy"),
+                    value: UserStats::new(
+                        UserStatsValue::String(Cow::Owned($strategy.to_string())),
+                        AggregatorOps::None,
+                    ),
+                    phantom: PhantomData,
+                },
+            )
+            .unwrap();
+
+            let deadline = std::time::Instant::now() + $opts.fuzz_duration;
+            #[cfg(feature = "introspection")]
+            let (start_cycles, mut next_report) = (
+                libafl_bolts::cpu::read_time_counter(),
+                std::time::Instant::now(),
+            );
+            loop {
+                let now = std::time::Instant::now();
+                if now >= deadline || crate::session::stop_requested() {
+                    break;
+                }
+                #[cfg(feature = "introspection")]
+                if now >= next_report {
+                    next_report = now + crate::engine::STATS_REPORT_INTERVAL;
+                    let _ = $mgr.fire(
+                        &mut $state,
+                        crate::engine::reset_coverage_stats(start_cycles),
+                    );
+                }
+                let _ = fuzzer.fuzz_one(&mut stages, &mut executor, &mut $state, &mut $mgr);
+            }
+            crate::objectives::flush_buckets();
+        }
+    }};
+}
+
+use grammar_client;
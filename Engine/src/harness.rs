@@ -4,7 +4,6 @@ use libafl::inputs::{BytesInput, HasTargetBytes};
 use libafl_bolts::AsSlice;
 
 #[cfg(not(feature = "std"))]
-#[allow(unused_imports)]
 use alloc::vec::Vec;
 
 use crate::sanitizer_coverage::reset_coverage;
@@ -27,12 +26,15 @@ pub fn bytes_harness(target_fn: CTargetFn) -> impl FnMut(&BytesInput) -> ExitKin
 
 /// Build a harness for null-terminated string targets.
 pub fn string_harness(target_fn: CTargetStringFn) -> impl FnMut(&BytesInput) -> ExitKind {
+    // Reused across executions so the terminator copy does not allocate.
+    let mut owned = Vec::new();
     move |input: &BytesInput| {
         let target = input.target_bytes();
         let buf = target.as_slice();
 
         // Append null terminator
-        let mut owned = buf.to_vec();
+        owned.clear();
+        owned.extend_from_slice(buf);
         owned.push(0);
 
         unsafe {
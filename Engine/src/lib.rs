@@ -6,14 +6,36 @@ extern crate alloc;
 #[cfg(not(feature = "std"))]
 mod allocator;
 
+mod cmplog;
 pub mod config;
+mod dedup;
 mod engine;
+#[cfg(feature = "std")]
+mod exec_time;
+mod generators;
+#[cfg(feature = "grammar")]
+mod grammar;
 mod harness;
+#[cfg(feature = "std")]
+mod metrics;
 mod monitors;
+mod mutators;
+#[cfg(feature = "std")]
+mod objectives;
+#[cfg(feature = "std")]
+mod perf;
 pub mod sanitizer_coverage;
 mod schedulers;
+#[cfg(feature = "std")]
+pub mod session;
+#[cfg(feature = "std")]
+mod stages;
+#[cfg(feature = "std")]
+mod stats_files;
+#[cfg(feature = "std")]
+mod strategy;
 pub mod targets;
-use config::{HarnessType, PeelFuzzConfig, SchedulerType};
+use config::{HarnessType, PeelFuzzConfig};
 use core::time::Duration;
 pub use engine::PeelFuzzer;
 
@@ -22,38 +44,27 @@ pub use engine::PeelFuzzer;
 pub unsafe extern "C" fn peel_fuzz_run(config: *const PeelFuzzConfig) {
     unsafe {
         let cfg = &*config;
-        let timeout = Duration::from_millis(cfg.timeout_ms_or_default());
-        let fuzz_duration = Duration::from_secs(cfg.timer_sec_or_default());
-        let crash_dir = cfg.crash_dir_or_default();
-        let seed_count = cfg.seed_count_or_default();
-        let core_count = cfg.core_count_or_default();
 
         match cfg.harness_type {
             HarnessType::ByteSize => {
                 let target_fn: targets::CTargetFn = core::mem::transmute(cfg.target_fn);
                 let h = harness::bytes_harness(target_fn);
-                build_and_run(
-                    h,
-                    cfg.scheduler_type,
-                    timeout,
-                    fuzz_duration,
-                    &crash_dir,
-                    seed_count,
-                    core_count,
-                );
+                build_and_run(h, cfg);
             }
             HarnessType::String => {
                 let target_fn: targets::CTargetStringFn = core::mem::transmute(cfg.target_fn);
                 let h = harness::string_harness(target_fn);
-                build_and_run(
-                    h,
-                    cfg.scheduler_type,
-                    timeout,
-                    fuzz_duration,
-                    &crash_dir,
-                    seed_count,
-                    core_count,
-                );
+                build_and_run(h, cfg);
+            }
+            HarnessType::Grammar => {
+                #[cfg(feature = "grammar")]
+                {
+                    let target_fn: targets::CTargetFn = core::mem::transmute(cfg.target_fn);
+                    let grammar = grammar::GrammarTarget::from_config(target_fn, cfg);
+                    configure(PeelFuzzer::new(grammar), cfg).run_grammar();
+                }
+                #[cfg(not(feature = "grammar"))]
+                panic!("HARNESS_GRAMMAR requires PeelFuzz built with the `grammar` feature");
             }
         }
     }
@@ -61,22 +72,66 @@ pub unsafe extern "C" fn peel_fuzz_run(config: *const PeelFuzzConfig) {
 
 unsafe fn build_and_run(
     harness: impl FnMut(&libafl::inputs::BytesInput) -> libafl::executors::ExitKind,
-    scheduler_type: SchedulerType,
-    timeout: Duration,
-    fuzz_duration: Duration,
-    crash_dir: &str,
-    seed_count: usize,
-    core_count: usize,
+    cfg: &PeelFuzzConfig,
 ) {
-    let builder = PeelFuzzer::new(harness)
-        .scheduler(scheduler_type)
-        .timeout(timeout)
-        .fuzz_duration(fuzz_duration)
-        .crash_dir(crash_dir)
-        .seed_count(seed_count)
-        .core_count(core_count);
+    unsafe { configure(PeelFuzzer::new(harness), cfg).run() };
+}
+
+/// Apply every config field to the builder.
+fn configure<H>(builder: PeelFuzzer<H>, cfg: &PeelFuzzConfig) -> PeelFuzzer<H> {
+    let builder = builder
+        .scheduler(cfg.scheduler_type)
+        .mutator(cfg.mutator_type)
+        .timeout(Duration::from_millis(cfg.timeout_ms_or_default()))
+        .fuzz_duration(Duration::from_secs(cfg.timer_sec_or_default()))
+        .crash_dir(&cfg.crash_dir_or_default())
+        .hang_dir(&cfg.hang_dir_or_default())
+        .slow_inputs(&cfg.slow_dir_or_default(), cfg.slow_input_count as usize)
+        .fuzz_mode(
+            cfg.fuzz_mode,
+            cfg.perf_hit_budget,
+            &cfg.perf_dir_or_default(),
+        )
+        .latency_budget(cfg.latency_budget_us, &cfg.slow_inputs_dir_or_default())
+        .seed_count(cfg.seed_count_or_default())
+        .core_count(cfg.core_count_or_default())
+        .trim_pct(cfg.trim_pct)
+        .custom_mutator(
+            cfg.custom_mutator_fn,
+            cfg.custom_crossover_fn,
+            cfg.custom_mutator_mode,
+        )
+        .fixup(cfg.fixup_fn)
+        .checksum_repair(cfg.checksum_repair != 0)
+        .grimoire(cfg.harness_type == HarnessType::String)
+        .string_input(cfg.harness_type == HarnessType::String)
+        .max_input_len(cfg.max_input_len_or_default())
+        .len_control(cfg.len_control)
+        .input_cache_slots(cfg.input_cache_slots_or_default())
+        .stats_callback(
+            cfg.stats_cb,
+            cfg.stats_cb_ctx,
+            Duration::from_millis(cfg.stats_cb_interval_ms as u64),
+        );
+    #[cfg(feature = "std")]
+    let builder = builder
+        .strategy_plan(&cfg.strategy_plan_or_default())
+        .stop_after_objectives(cfg.stop_after_objectives as u64)
+        .stop_on_plateau(
+            (cfg.stop_plateau_sec > 0).then(|| Duration::from_secs(cfg.stop_plateau_sec as u64)),
+        )
+        .stats_dir(
+            cfg.stats_dir_or_default().as_deref(),
+            Duration::from_secs(cfg.stats_interval_sec_or_default()),
+        )
+        .monitor_interval(
+            (cfg.monitor_interval_sec > 0)
+                .then(|| Duration::from_secs(cfg.monitor_interval_sec as u64)),
+            cfg.monitor_per_client != 0,
+        )
+        .metrics_port((cfg.metrics_port > 0).then_some(cfg.metrics_port));
 
-    unsafe { builder.run() };
+    builder
 }
 
 // --- no_std required symbols ---
@@ -0,0 +1,254 @@
+/// OpenMetrics (Prometheus) endpoint served by the broker.
+///
+/// The broker renders the aggregate client stats it already receives into an
+/// OpenMetrics text page, at most once per `REFRESH`, and a background thread
+/// serves the latest page to every `GET` on a local port. Clients do no extra
+/// work. The thread is started on the first update, which only ever runs in
+/// the broker, so forked clients never inherit the listener.
+use std::fmt::Write as _;
+use std::io::{Read as _, Write as _};
+use std::net::{Ipv4Addr, TcpListener, TcpStream};
+use std::sync::{Arc, Mutex};
+use std::time::{Duration, Instant};
+
+use libafl::statistics::manager::ClientStatsManager;
+use libafl::statistics::user_stats::UserStatsValue;
+
+/// Minimum time between two renders of the page.
+const REFRESH: Duration = Duration::from_secs(1);
+
+/// Name of the calibration stage's stability stat.
+const STABILITY_STAT: &str = "stability";
+
+const CONTENT_TYPE: &str = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+
+pub struct MetricsServer {
+    port: u16,
+    page: Arc<Mutex<String>>,
+    started: bool,
+    next_render: Instant,
+}
+
+impl MetricsServer {
+    /// Serve on `127.0.0.1:port`.
+    pub fn new(port: u16) -> Self {
+        Self {
+            port,
+            page: Arc::new(Mutex::new(String::from("# EOF\n"))),
+            started: false,
+            next_render: Instant::now(),
+        }
+    }
+
+    /// Re-render the page if `REFRESH` has passed, starting the server on the
+    /// first call.
+    pub fn update(&mut self, stats: &mut ClientStatsManager) {
+        if !self.started {
+            self.started = true;
+            self.spawn();
+        }
+
+        let now = Instant::now();
+        if now < self.next_render {
+            return;
+        }
+        self.next_render = now + REFRESH;
+
+        let page = render(stats);
+        if let Ok(mut current) = self.page.lock() {
+            *current = page;
+        }
+    }
+
+    fn spawn(&self) {
+        let listener = match TcpListener::bind((Ipv4Addr::LOCALHOST, self.port)) {
+            Ok(listener) => listener,
+            Err(e) => {
+                println!(
+                    "[PeelFuzz] Metrics endpoint disabled, cannot bind port {}: {e}",
+                    self.port
+                );
+                return;
+            }
+        };
+        println!(
+            "[PeelFuzz] Serving metrics on http://127.0.0.1:{}/metrics",
+            self.port
+        );
+
+        let page = Arc::clone(&self.page);
+        std::thread::spawn(move || {
+            for stream in listener.incoming().flatten() {
+                let body = page.lock().map(|p| p.clone()).unwrap_or_default();
+                let _ = respond(stream, &body);
+            }
+        });
+    }
+}
+
+/// Answer one request with the current page, whatever the path.
+fn respond(mut stream: TcpStream, body: &str) -> std::io::Result<()> {
+    stream.set_read_timeout(Some(Duration::from_secs(1)))?;
+    // Only the request line matters; the rest is drained on a best-effort basis.
+    let mut request = [0u8; 1024];
+    let _ = stream.read(&mut request)?;
+
+    write!(
+        stream,
+        "HTTP/1.1 200 OK\r\nContent-Type: {CONTENT_TYPE}\r\nContent-Length: {}\r\nConnection: close\r\n\r\n{body}",
+        body.len()
+    )
+}
+
+fn render(stats: &mut ClientStatsManager) -> String {
+    let (edges_hit, edges_total) = crate::monitors::edges(stats);
+    let global = stats.global_stats();
+
+    let mut out = String::new();
+    metric(
+        &mut out,
+        "peelfuzz_executions",
+        "counter",
+        "Target executions over all clients.",
+    );
+    let _ = writeln!(out, "peelfuzz_executions_total {}", global.total_execs);
+    metric(
+        &mut out,
+        "peelfuzz_execs_per_second",
+        "gauge",
+        "Executions per second over all clients.",
+    );
+    let _ = writeln!(out, "peelfuzz_execs_per_second {:.2}", global.execs_per_sec);
+    metric(
+        &mut out,
+        "peelfuzz_corpus_size",
+        "gauge",
+        "Corpus entries over all clients.",
+    );
+    let _ = writeln!(out, "peelfuzz_corpus_size {}", global.corpus_size);
+    metric(
+        &mut out,
+        "peelfuzz_objectives",
+        "counter",
+        "Objectives (deduplicated crashes) found.",
+    );
+    let _ = writeln!(out, "peelfuzz_objectives_total {}", global.objective_size);
+    metric(
+        &mut out,
+        "peelfuzz_edges_covered",
+        "gauge",
+        "Coverage map edges hit.",
+    );
+    let _ = writeln!(out, "peelfuzz_edges_covered {edges_hit}");
+    metric(
+        &mut out,
+        "peelfuzz_edges_total",
+        "gauge",
+        "Coverage map size.",
+    );
+    let _ = writeln!(out, "peelfuzz_edges_total {edges_total}");
+    metric(
+        &mut out,
+        "peelfuzz_clients",
+        "gauge",
+        "Connected fuzzing clients.",
+    );
+    let _ = writeln!(out, "peelfuzz_clients {}", global.client_stats_count);
+    metric(
+        &mut out,
+        "peelfuzz_run_time_seconds",
+        "gauge",
+        "Campaign run time.",
+    );
+    let _ = writeln!(
+        out,
+        "peelfuzz_run_time_seconds {}",
+        global.run_time.as_secs()
+    );
+
+    if let Some(times) = crate::exec_time::ExecTimes::merged() {
+        metric(
+            &mut out,
+            "peelfuzz_exec_time_seconds",
+            "histogram",
+            "Target execution time over all clients.",
+        );
+        // Bounds one below each power of two, which the histogram counts
+        // exactly, up to the first one that holds every run.
+        for shift in 0..64 {
+            let bound = (1u64 << shift) - 1;
+            let at_most = times.count_at_most(bound);
+            let _ = writeln!(
+                out,
+                "peelfuzz_exec_time_seconds_bucket{{le=\"{}\"}} {at_most}",
+                bound as f64 / 1e6
+            );
+            if at_most == times.total {
+                break;
+            }
+        }
+        let _ = writeln!(
+            out,
+            "peelfuzz_exec_time_seconds_bucket{{le=\"+Inf\"}} {}",
+            times.total
+        );
+        let _ = writeln!(out, "peelfuzz_exec_time_seconds_count {}", times.total);
+        let _ = writeln!(
+            out,
+            "peelfuzz_exec_time_seconds_sum {}",
+            times.sum_micros as f64 / 1e6
+        );
+    }
+
+    let mut clients: Vec<_> = stats
+        .client_stats()
+        .iter()
+        .filter(|(_, client)| client.enabled())
+        .collect();
+    clients.sort_by_key(|(id, _)| id.0);
+
+    metric(
+        &mut out,
+        "peelfuzz_client_executions",
+        "counter",
+        "Target executions per client.",
+    );
+    for (id, client) in &clients {
+        let _ = writeln!(
+            out,
+            "peelfuzz_client_executions_total{{client=\"{}\"}} {}",
+            id.0,
+            client.executions()
+        );
+    }
+    // Only reported by clients whose scheduler runs the calibration stage.
+    metric(
+        &mut out,
+        "peelfuzz_client_stability",
+        "gauge",
+        "Share of map entries with stable hit counts, per client.",
+    );
+    for (id, client) in &clients {
+        if let Some(UserStatsValue::Ratio(stable, total)) = client
+            .get_user_stats(STABILITY_STAT)
+            .map(|stat| stat.value())
+        {
+            if *total > 0 {
+                let _ = writeln!(
+                    out,
+                    "peelfuzz_client_stability{{client=\"{}\"}} {:.4}",
+                    id.0,
+                    *stable as f64 / *total as f64
+                );
+            }
+        }
+    }
+
+    out.push_str("# EOF\n");
+    out
+}
+
+fn metric(out: &mut String, name: &str, kind: &str, help: &str) {
+    let _ = writeln!(out, "# TYPE {name} {kind}");
+    let _ = writeln!(out, "# HELP {name} {help}");
+}
@@ -1,6 +1,360 @@
+use core::ffi::c_void;
+use core::time::Duration;
+
+use libafl::statistics::user_stats::UserStatsValue;
+use libafl::{Error, monitors::Monitor, statistics::manager::ClientStatsManager};
+use libafl_bolts::ClientId;
+
+use crate::config::PeelFuzzStats;
+use crate::targets::CStatsFn;
+
+#[cfg(feature = "std")]
+use std::time::Instant;
+
+use crate::engine::FuzzOptions;
 #[cfg(feature = "std")]
-pub fn multi_monitor() -> libafl::monitors::MultiMonitor<fn(&str)> {
-    libafl::monitors::MultiMonitor::new(print_status as fn(&str))
+use crate::metrics::MetricsServer;
+#[cfg(feature = "std")]
+use crate::stats_files::StatsFiles;
+
+#[cfg(feature = "std")]
+pub fn multi_monitor(opts: &FuzzOptions) -> PeelMonitor<StatusMonitor> {
+    let status = match opts.monitor_interval {
+        Some(interval) => {
+            StatusMonitor::Summary(SummaryMonitor::new(interval, opts.monitor_per_client))
+        }
+        None => StatusMonitor::Every(libafl::monitors::MultiMonitor::new(
+            print_status as fn(&str),
+        )),
+    };
+    PeelMonitor::new(
+        status,
+        StopPolicy::new(opts.stop_objectives, opts.stop_plateau),
+    )
+    .with_stats_files(
+        opts.stats_dir
+            .as_deref()
+            .map(|dir| StatsFiles::new(dir, opts.stats_interval)),
+    )
+    .with_metrics(opts.metrics_port.map(MetricsServer::new))
+    .with_stats_callback(opts.stats_cb.map(StatsReporter::new))
+}
+
+/// Name of the coverage map observer, whose feedback reports edges hit.
+const EDGES_STAT: &str = "signals";
+
+/// Edges hit and map size, aggregated over all clients.
+pub fn edges(stats: &ClientStatsManager) -> (u64, u64) {
+    match stats.aggregated().get(EDGES_STAT) {
+        Some(UserStatsValue::Ratio(hit, total)) => (*hit, *total),
+        _ => (0, 0),
+    }
+}
+
+/// Percent of map entries hit.
+pub fn map_density(edges_hit: u64, edges_total: u64) -> f64 {
+    if edges_total == 0 {
+        0.0
+    } else {
+        edges_hit as f64 * 100.0 / edges_total as f64
+    }
+}
+
+/// Fixed-layout copy of the aggregate stats, as handed to C.
+pub fn stats_snapshot(stats: &mut ClientStatsManager) -> PeelFuzzStats {
+    let (edges_hit, edges_total) = edges(stats);
+    let global = stats.global_stats();
+    PeelFuzzStats {
+        executions: global.total_execs,
+        execs_per_sec: global.execs_per_sec,
+        corpus_count: global.corpus_size,
+        objective_count: global.objective_size,
+        edges_hit,
+        edges_total,
+        run_time_sec: global.run_time.as_secs(),
+        clients: global.client_stats_count as u32,
+        running: 1,
+        map_density: map_density(edges_hit, edges_total),
+    }
+}
+
+/// A C stats callback with its context pointer.
+#[derive(Debug, Clone, Copy)]
+pub struct StatsCallback {
+    pub func: CStatsFn,
+    pub ctx: *mut c_void,
+    /// Minimum time between two calls. Zero = on every stats event.
+    pub interval: Duration,
+}
+
+// The context belongs to the caller, who registered it for the monitor's
+// thread; PeelFuzz only passes it back.
+unsafe impl Send for StatsCallback {}
+unsafe impl Sync for StatsCallback {}
+
+/// Calls a `StatsCallback` with aggregate stats, at most once per interval.
+pub struct StatsReporter {
+    cb: StatsCallback,
+    next_call: Duration,
+}
+
+impl StatsReporter {
+    pub fn new(cb: StatsCallback) -> Self {
+        Self {
+            cb,
+            next_call: Duration::ZERO,
+        }
+    }
+
+    pub fn update(&mut self, stats: &mut ClientStatsManager) {
+        // `current_time` is `external_current_millis` on no_std.
+        let now = libafl_bolts::current_time();
+        if now < self.next_call {
+            return;
+        }
+        self.next_call = now + self.cb.interval;
+
+        let snapshot = stats_snapshot(stats);
+        unsafe { (self.cb.func)(&snapshot, self.cb.ctx) };
+    }
+}
+
+/// Status output of the broker: a line per client event, or one aggregate
+/// summary per interval.
+#[cfg(feature = "std")]
+pub enum StatusMonitor {
+    Every(libafl::monitors::MultiMonitor<fn(&str)>),
+    Summary(SummaryMonitor),
+}
+
+#[cfg(feature = "std")]
+impl Monitor for StatusMonitor {
+    fn display(
+        &mut self,
+        client_stats_manager: &mut ClientStatsManager,
+        event_msg: &str,
+        sender_id: ClientId,
+    ) -> Result<(), Error> {
+        match self {
+            Self::Every(mon) => mon.display(client_stats_manager, event_msg, sender_id),
+            Self::Summary(mon) => mon.display(client_stats_manager, event_msg, sender_id),
+        }
+    }
+}
+
+/// Prints one aggregate line at most once per `interval`, however many events
+/// the clients send. On high core counts this keeps the broker from spending
+/// its time formatting and writing a line for every client event.
+#[cfg(feature = "std")]
+pub struct SummaryMonitor {
+    interval: Duration,
+    per_client: bool,
+    next_print: Instant,
+}
+
+#[cfg(feature = "std")]
+impl SummaryMonitor {
+    /// `per_client` adds one detail line per client under each summary.
+    pub fn new(interval: Duration, per_client: bool) -> Self {
+        Self {
+            interval,
+            per_client,
+            next_print: Instant::now(),
+        }
+    }
+}
+
+#[cfg(feature = "std")]
+impl Monitor for SummaryMonitor {
+    fn display(
+        &mut self,
+        client_stats_manager: &mut ClientStatsManager,
+        _event_msg: &str,
+        _sender_id: ClientId,
+    ) -> Result<(), Error> {
+        let now = Instant::now();
+        if now < self.next_print {
+            return Ok(());
+        }
+        self.next_print = now + self.interval;
+
+        let (edges_hit, edges_total) = crate::monitors::edges(client_stats_manager);
+        let global = client_stats_manager.global_stats();
+        let mut out = format!(
+            "[PeelFuzz] run time: {}s, clients: {}, corpus: {}, objectives: {}, executions: {}, exec/sec: {:.0}, edges: {}/{}",
+            global.run_time.as_secs(),
+            global.client_stats_count,
+            global.corpus_size,
+            global.objective_size,
+            global.total_execs,
+            global.execs_per_sec,
+            edges_hit,
+            edges_total,
+        );
+        if let Some(times) = crate::exec_time::ExecTimes::merged() {
+            out.push_str(&format!(
+                ", exec time p50/p99/p999: {}/{}/{}us",
+                times.percentile(0.5),
+                times.percentile(0.99),
+                times.percentile(0.999),
+            ));
+        }
+        if self.per_client {
+            let mut clients: Vec<_> = client_stats_manager
+                .client_stats()
+                .iter()
+                .filter(|(_, client)| client.enabled())
+                .collect();
+            clients.sort_by_key(|(id, _)| id.0);
+            for (id, client) in clients {
+                out.push_str(&format!(
+                    "\n    client {}: corpus: {}, objectives: {}, executions: {}",
+                    id.0,
+                    client.corpus_size(),
+                    client.objective_size(),
+                    client.executions(),
+                ));
+                // Per-stage, per-feedback share of the client's cycles.
+                #[cfg(feature = "introspection")]
+                out.push_str(&format!("\n{}", client.introspection_stats()));
+            }
+        }
+        println!("{out}");
+        Ok(())
+    }
+}
+
+/// Conditions under which the broker ends the campaign early.
+#[cfg(feature = "std")]
+pub struct StopPolicy {
+    max_objectives: u64,
+    plateau: Option<Duration>,
+    best_edges: u64,
+    last_new_edge: Instant,
+}
+
+#[cfg(feature = "std")]
+impl StopPolicy {
+    /// `max_objectives` = 0 and `plateau` = None never stop.
+    pub fn new(max_objectives: u64, plateau: Option<Duration>) -> Self {
+        Self {
+            max_objectives,
+            plateau,
+            best_edges: 0,
+            last_new_edge: Instant::now(),
+        }
+    }
+
+    /// Check the aggregate stats; returns the reason to stop, if any.
+    fn check(&mut self, stats: &mut ClientStatsManager) -> Option<String> {
+        let objectives = stats.global_stats().objective_size;
+        if self.max_objectives > 0 && objectives >= self.max_objectives {
+            return Some(format!("{objectives} objective(s) found"));
+        }
+
+        let plateau = self.plateau?;
+        let (edges, _) = crate::monitors::edges(stats);
+        if edges > self.best_edges {
+            self.best_edges = edges;
+            self.last_new_edge = Instant::now();
+        } else if self.last_new_edge.elapsed() >= plateau {
+            return Some(format!(
+                "no new edges for {}s",
+                self.last_new_edge.elapsed().as_secs()
+            ));
+        }
+        None
+    }
+}
+
+/// Minimum time between two rounds of aggregate work in the broker. Client
+/// events can arrive thousands of times per second on many cores, and each
+/// round walks every client's stats.
+#[cfg(feature = "std")]
+const AGGREGATE_INTERVAL: Duration = Duration::from_millis(250);
+
+/// Broker-side monitor: forwards every event to `inner` for display. At most
+/// once per `AGGREGATE_INTERVAL` it also publishes the aggregate stats to a
+/// background session, the stats files, the metrics endpoint and the stats
+/// callback, if any, and stops all clients when the stop policy fires.
+#[cfg(feature = "std")]
+pub struct PeelMonitor<M> {
+    inner: M,
+    next_aggregate: Instant,
+    stop: StopPolicy,
+    stopping: bool,
+    stats_files: Option<StatsFiles>,
+    metrics: Option<MetricsServer>,
+    stats_cb: Option<StatsReporter>,
+}
+
+#[cfg(feature = "std")]
+impl<M> PeelMonitor<M> {
+    pub fn new(inner: M, stop: StopPolicy) -> Self {
+        Self {
+            inner,
+            next_aggregate: Instant::now(),
+            stop,
+            stopping: false,
+            stats_files: None,
+            metrics: None,
+            stats_cb: None,
+        }
+    }
+
+    pub fn with_stats_files(mut self, stats_files: Option<StatsFiles>) -> Self {
+        self.stats_files = stats_files;
+        self
+    }
+
+    pub fn with_metrics(mut self, metrics: Option<MetricsServer>) -> Self {
+        self.metrics = metrics;
+        self
+    }
+
+    pub fn with_stats_callback(mut self, stats_cb: Option<StatsReporter>) -> Self {
+        self.stats_cb = stats_cb;
+        self
+    }
+}
+
+#[cfg(feature = "std")]
+impl<M: Monitor> Monitor for PeelMonitor<M> {
+    fn display(
+        &mut self,
+        client_stats_manager: &mut ClientStatsManager,
+        event_msg: &str,
+        sender_id: ClientId,
+    ) -> Result<(), Error> {
+        self.inner
+            .display(client_stats_manager, event_msg, sender_id)?;
+
+        let now = Instant::now();
+        if now < self.next_aggregate {
+            return Ok(());
+        }
+        self.next_aggregate = now + AGGREGATE_INTERVAL;
+
+        crate::session::publish(client_stats_manager);
+        if let Some(files) = &mut self.stats_files {
+            files.update(client_stats_manager);
+        }
+        if let Some(metrics) = &mut self.metrics {
+            metrics.update(client_stats_manager);
+        }
+        if let Some(reporter) = &mut self.stats_cb {
+            reporter.update(client_stats_manager);
+        }
+
+        if !self.stopping {
+            if let Some(reason) = self.stop.check(client_stats_manager) {
+                self.stopping = true;
+                println!("[PeelFuzz] Stopping all clients: {reason}");
+                crate::session::request_stop();
+            }
+        }
+        Ok(())
+    }
 }
 
 #[cfg(feature = "std")]
@@ -8,20 +362,34 @@ fn print_status(s: &str) {
     println!("{s}");
 }
 
-/// Returns a `SimpleMonitor` with a no-op callback for no_std builds.
-///
-/// By default this discards all status output since there is no stdout on
-/// baremetal. To see fuzzer stats on your hardware, replace the closure
-/// with your platform's print function — for example, write to a UART
-/// peripheral, SWO trace port, or semihosting channel:
-///
-/// ```ignore
-/// SimpleMonitor::new(|s| my_uart_write(s))
-/// ```
+/// Monitor for no_std builds: there is no stdout on baremetal, so status is
+/// only reported through the stats callback, if one is set. To watch a
+/// campaign on your hardware, register a `stats_cb` that writes to a UART
+/// peripheral, SWO trace port, or semihosting channel. On no_std the interval
+/// is measured with `external_current_millis`.
 #[cfg(not(feature = "std"))]
-pub fn simple_monitor() -> libafl::monitors::SimpleMonitor<fn(&str)> {
-    libafl::monitors::SimpleMonitor::new(noop_print as fn(&str))
+pub fn simple_monitor(opts: &FuzzOptions) -> CallbackMonitor {
+    CallbackMonitor {
+        reporter: opts.stats_cb.map(StatsReporter::new),
+    }
 }
 
 #[cfg(not(feature = "std"))]
-fn noop_print(_s: &str) {}
+pub struct CallbackMonitor {
+    reporter: Option<StatsReporter>,
+}
+
+#[cfg(not(feature = "std"))]
+impl Monitor for CallbackMonitor {
+    fn display(
+        &mut self,
+        client_stats_manager: &mut ClientStatsManager,
+        _event_msg: &str,
+        _sender_id: ClientId,
+    ) -> Result<(), Error> {
+        if let Some(reporter) = &mut self.reporter {
+            reporter.update(client_stats_manager);
+        }
+        Ok(())
+    }
+}
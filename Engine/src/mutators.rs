@@ -0,0 +1,475 @@
+/// Mutator wrappers selected at runtime from the C config.
+use core::num::NonZero;
+
+use libafl::corpus::{Corpus, CorpusId};
+#[cfg(feature = "std")]
+use libafl::inputs::GeneralizedInputMetadata;
+use libafl::inputs::{BytesInput, HasMutatorBytes, ResizableMutator};
+use libafl::mutators::{MutationResult, Mutator};
+use libafl::state::{HasCorpus, HasMaxSize, HasRand};
+use libafl::{Error, random_corpus_id};
+use libafl_bolts::Named;
+use libafl_bolts::rands::Rand;
+
+#[cfg(not(feature = "std"))]
+use alloc::{borrow::Cow, vec::Vec};
+#[cfg(feature = "std")]
+use std::borrow::Cow;
+
+use crate::config::MutatorType;
+use crate::targets::{CCustomCrossOverFn, CCustomMutatorFn, CFixupFn};
+
+/// Run the user's fixup callback, if any, over `bytes` in place.
+#[inline]
+pub fn apply_fixup(fixup: Option<CFixupFn>, bytes: &mut [u8]) {
+    if let Some(fixup) = fixup {
+        if !bytes.is_empty() {
+            unsafe { fixup(bytes.as_mut_ptr(), bytes.len()) };
+        }
+    }
+}
+
+/// Havoc with a fixed uniform operator mix, or MOpt, which re-weights the same
+/// operators by how often each one yields new coverage on this target.
+pub enum PeelMutator<H, M> {
+    Havoc(H),
+    MOpt(M),
+}
+
+impl<H, M> PeelMutator<H, M> {
+    /// Build the mutator named by `mutator_type`. Only the selected
+    /// constructor runs, so MOpt metadata is added to the state only when used.
+    pub fn select(
+        mutator_type: MutatorType,
+        havoc: impl FnOnce() -> H,
+        mopt: impl FnOnce() -> M,
+    ) -> Self {
+        match mutator_type {
+            MutatorType::Havoc => Self::Havoc(havoc()),
+            MutatorType::MOpt => Self::MOpt(mopt()),
+        }
+    }
+}
+
+impl<H, M> Named for PeelMutator<H, M>
+where
+    H: Named,
+    M: Named,
+{
+    fn name(&self) -> &Cow<'static, str> {
+        match self {
+            Self::Havoc(m) => m.name(),
+            Self::MOpt(m) => m.name(),
+        }
+    }
+}
+
+impl<I, S, H, M> Mutator<I, S> for PeelMutator<H, M>
+where
+    H: Mutator<I, S>,
+    M: Mutator<I, S>,
+{
+    fn mutate(&mut self, state: &mut S, input: &mut I) -> Result<MutationResult, Error> {
+        match self {
+            Self::Havoc(m) => m.mutate(state, input),
+            Self::MOpt(m) => m.mutate(state, input),
+        }
+    }
+
+    fn post_exec(&mut self, state: &mut S, new_corpus_id: Option<CorpusId>) -> Result<(), Error> {
+        match self {
+            Self::Havoc(m) => m.post_exec(state, new_corpus_id),
+            Self::MOpt(m) => m.post_exec(state, new_corpus_id),
+        }
+    }
+}
+
+/// Wraps libFuzzer-style `LLVMFuzzerCustomMutator` / `LLVMFuzzerCustomCrossOver`
+/// callbacks as a LibAFL mutator.
+///
+/// The mutate callback works in place: the input is resized to `max_size`,
+/// mutated in its own buffer and truncated to the returned length. Crossover
+/// must not overwrite its first operand, so it writes into a scratch buffer of
+/// `max_size` bytes, allocated once, which is then copied into the input.
+pub struct CustomMutator {
+    mutate_fn: Option<CCustomMutatorFn>,
+    crossover_fn: Option<CCustomCrossOverFn>,
+    scratch: Vec<u8>,
+}
+
+impl CustomMutator {
+    pub fn new(
+        mutate_fn: Option<CCustomMutatorFn>,
+        crossover_fn: Option<CCustomCrossOverFn>,
+    ) -> Self {
+        Self {
+            mutate_fn,
+            crossover_fn,
+            scratch: Vec::new(),
+        }
+    }
+
+    /// True if at least one callback was supplied.
+    pub fn is_enabled(&self) -> bool {
+        self.mutate_fn.is_some() || self.crossover_fn.is_some()
+    }
+}
+
+impl Named for CustomMutator {
+    fn name(&self) -> &Cow<'static, str> {
+        static NAME: Cow<'static, str> = Cow::Borrowed("CustomMutator");
+        &NAME
+    }
+}
+
+impl<S> Mutator<BytesInput, S> for CustomMutator
+where
+    S: HasRand + HasMaxSize + HasCorpus<BytesInput>,
+{
+    fn mutate(&mut self, state: &mut S, input: &mut BytesInput) -> Result<MutationResult, Error> {
+        let max_size = state.max_size();
+        let seed = state.rand_mut().next() as u32;
+
+        // With both callbacks set, split the work evenly between them.
+        let use_crossover = match (self.mutate_fn, self.crossover_fn) {
+            (None, None) => return Ok(MutationResult::Skipped),
+            (Some(_), None) => false,
+            (None, Some(_)) => true,
+            (Some(_), Some(_)) => state.rand_mut().coinflip(0.5),
+        };
+
+        if !use_crossover {
+            let mutate = self.mutate_fn.unwrap();
+            let len = input.mutator_bytes().len().min(max_size);
+            input.resize(max_size, 0);
+            let data = input.mutator_bytes_mut();
+            let new_len = unsafe { mutate(data.as_mut_ptr(), len, max_size, seed) }.min(max_size);
+            if new_len == 0 {
+                input.resize(len, 0);
+                return Ok(MutationResult::Skipped);
+            }
+            input.resize(new_len, 0);
+            return Ok(MutationResult::Mutated);
+        }
+
+        if self.scratch.len() < max_size {
+            self.scratch.resize(max_size, 0);
+        }
+        let new_len = {
+            let crossover = self.crossover_fn.unwrap();
+            let id = random_corpus_id!(state.corpus(), state.rand_mut());
+            let mut other_testcase = state.corpus().get(id)?.borrow_mut();
+            let other = other_testcase.load_input(state.corpus())?.mutator_bytes();
+            let data = input.mutator_bytes();
+            unsafe {
+                crossover(
+                    data.as_ptr(),
+                    data.len(),
+                    other.as_ptr(),
+                    other.len(),
+                    self.scratch.as_mut_ptr(),
+                    max_size,
+                    seed,
+                )
+            }
+        };
+
+        let new_len = new_len.min(max_size);
+        if new_len == 0 {
+            return Ok(MutationResult::Skipped);
+        }
+        input.resize(new_len, 0);
+        input
+            .mutator_bytes_mut()
+            .copy_from_slice(&self.scratch[..new_len]);
+        Ok(MutationResult::Mutated)
+    }
+
+    fn post_exec(&mut self, _state: &mut S, _new_corpus_id: Option<CorpusId>) -> Result<(), Error> {
+        Ok(())
+    }
+}
+
+/// Applies the user's fixup to every input the inner mutator changed, before it
+/// is executed. The stage stores the same fixed-up input in the corpus or as a
+/// crash, so saved files replay exactly.
+pub struct FixupMutator<M> {
+    inner: M,
+    fixup: Option<CFixupFn>,
+}
+
+impl<M> FixupMutator<M> {
+    pub fn new(inner: M, fixup: Option<CFixupFn>) -> Self {
+        Self { inner, fixup }
+    }
+}
+
+impl<M> Named for FixupMutator<M>
+where
+    M: Named,
+{
+    fn name(&self) -> &Cow<'static, str> {
+        self.inner.name()
+    }
+}
+
+impl<S, M> Mutator<BytesInput, S> for FixupMutator<M>
+where
+    M: Mutator<BytesInput, S>,
+{
+    fn mutate(&mut self, state: &mut S, input: &mut BytesInput) -> Result<MutationResult, Error> {
+        let result = self.inner.mutate(state, input)?;
+        if result == MutationResult::Mutated {
+            apply_fixup(self.fixup, input.mutator_bytes_mut());
+        }
+        Ok(result)
+    }
+
+    fn post_exec(&mut self, state: &mut S, new_corpus_id: Option<CorpusId>) -> Result<(), Error> {
+        self.inner.post_exec(state, new_corpus_id)
+    }
+}
+
+/// For string targets: makes the inner mutator's output valid UTF-8 without
+/// NULs, so `strlen` sees the whole input and the target sees text. Valid
+/// multi-byte sequences are kept; NULs and every byte that is not part of a
+/// valid sequence become random printable ASCII. A no-op when `enabled` is
+/// false.
+pub struct TextMutator<M> {
+    inner: M,
+    enabled: bool,
+}
+
+impl<M> TextMutator<M> {
+    pub fn new(inner: M, enabled: bool) -> Self {
+        Self { inner, enabled }
+    }
+}
+
+impl<M> Named for TextMutator<M>
+where
+    M: Named,
+{
+    fn name(&self) -> &Cow<'static, str> {
+        self.inner.name()
+    }
+}
+
+impl<S, M> Mutator<BytesInput, S> for TextMutator<M>
+where
+    S: HasRand,
+    M: Mutator<BytesInput, S>,
+{
+    fn mutate(&mut self, state: &mut S, input: &mut BytesInput) -> Result<MutationResult, Error> {
+        let result = self.inner.mutate(state, input)?;
+        if self.enabled && result == MutationResult::Mutated {
+            make_text(state.rand_mut(), input.mutator_bytes_mut());
+        }
+        Ok(result)
+    }
+
+    fn post_exec(&mut self, state: &mut S, new_corpus_id: Option<CorpusId>) -> Result<(), Error> {
+        self.inner.post_exec(state, new_corpus_id)
+    }
+}
+
+/// Random printable ASCII byte (space to `~`).
+#[inline]
+fn printable<R: Rand>(rand: &mut R) -> u8 {
+    b' ' + rand.below(NonZero::new(95).unwrap()) as u8
+}
+
+/// Replace NULs and bytes outside valid UTF-8 sequences with printable ASCII.
+fn make_text<R: Rand>(rand: &mut R, bytes: &mut [u8]) {
+    let mut start = 0;
+    while let Err(e) = core::str::from_utf8(&bytes[start..]) {
+        let bad = start + e.valid_up_to();
+        // None: a sequence cut off by the end of the input.
+        let len = e.error_len().unwrap_or(bytes.len() - bad);
+        for byte in &mut bytes[bad..bad + len] {
+            *byte = printable(rand);
+        }
+        start = bad + len;
+    }
+    for byte in bytes.iter_mut().filter(|b| **b == 0) {
+        *byte = printable(rand);
+    }
+}
+
+/// Truncates mutated inputs to the state's current max size, so no stage
+/// executes an input longer than the length cap.
+pub struct LenCapMutator<M> {
+    inner: M,
+}
+
+impl<M> LenCapMutator<M> {
+    pub fn new(inner: M) -> Self {
+        Self { inner }
+    }
+}
+
+impl<M> Named for LenCapMutator<M>
+where
+    M: Named,
+{
+    fn name(&self) -> &Cow<'static, str> {
+        self.inner.name()
+    }
+}
+
+impl<S, M> Mutator<BytesInput, S> for LenCapMutator<M>
+where
+    S: HasMaxSize,
+    M: Mutator<BytesInput, S>,
+{
+    fn mutate(&mut self, state: &mut S, input: &mut BytesInput) -> Result<MutationResult, Error> {
+        let result = self.inner.mutate(state, input)?;
+        let max_size = state.max_size();
+        if input.mutator_bytes().len() > max_size {
+            input.resize(max_size, 0);
+        }
+        Ok(result)
+    }
+
+    fn post_exec(&mut self, state: &mut S, new_corpus_id: Option<CorpusId>) -> Result<(), Error> {
+        self.inner.post_exec(state, new_corpus_id)
+    }
+}
+
+/// Wrap a mutator with the per-input post-processing every stage applies:
+/// the length cap, UTF-8 text repair for string targets, then the user's
+/// fixup. Text repair follows the cap so truncation cannot split a sequence.
+pub fn finish_mutator<M>(
+    inner: M,
+    text: bool,
+    fixup: Option<CFixupFn>,
+) -> FixupMutator<TextMutator<LenCapMutator<M>>> {
+    FixupMutator::new(TextMutator::new(LenCapMutator::new(inner), text), fixup)
+}
+
+/// Stands in for a mutator that already changed the input, so the wrappers
+/// around it always post-process.
+#[cfg(feature = "std")]
+struct AlreadyMutated;
+
+#[cfg(feature = "std")]
+impl Named for AlreadyMutated {
+    fn name(&self) -> &Cow<'static, str> {
+        static NAME: Cow<'static, str> = Cow::Borrowed("AlreadyMutated");
+        &NAME
+    }
+}
+
+#[cfg(feature = "std")]
+impl<S> Mutator<BytesInput, S> for AlreadyMutated {
+    fn mutate(&mut self, _state: &mut S, _input: &mut BytesInput) -> Result<MutationResult, Error> {
+        Ok(MutationResult::Mutated)
+    }
+
+    fn post_exec(&mut self, _state: &mut S, _new_corpus_id: Option<CorpusId>) -> Result<(), Error> {
+        Ok(())
+    }
+}
+
+/// `finish_mutator` for Grimoire, whose mutators work on generalized inputs
+/// rather than bytes. Each mutated input is flattened to the bytes the target
+/// will see, post-processed, and stored back as one gapless fragment, which
+/// flattens to exactly those bytes when the stage executes it.
+#[cfg(feature = "std")]
+pub struct GeneralizedFinishMutator<M> {
+    inner: M,
+    finish: FixupMutator<TextMutator<LenCapMutator<AlreadyMutated>>>,
+}
+
+#[cfg(feature = "std")]
+impl<M> GeneralizedFinishMutator<M> {
+    pub fn new(inner: M, text: bool, fixup: Option<CFixupFn>) -> Self {
+        Self {
+            inner,
+            finish: finish_mutator(AlreadyMutated, text, fixup),
+        }
+    }
+}
+
+#[cfg(feature = "std")]
+impl<M> Named for GeneralizedFinishMutator<M>
+where
+    M: Named,
+{
+    fn name(&self) -> &Cow<'static, str> {
+        self.inner.name()
+    }
+}
+
+#[cfg(feature = "std")]
+impl<S, M> Mutator<GeneralizedInputMetadata, S> for GeneralizedFinishMutator<M>
+where
+    S: HasRand + HasMaxSize,
+    M: Mutator<GeneralizedInputMetadata, S>,
+{
+    fn mutate(
+        &mut self,
+        state: &mut S,
+        input: &mut GeneralizedInputMetadata,
+    ) -> Result<MutationResult, Error> {
+        let result = self.inner.mutate(state, input)?;
+        if result == MutationResult::Mutated {
+            let mut bytes = BytesInput::new(input.generalized_to_bytes());
+            self.finish.mutate(state, &mut bytes)?;
+            let finished: Vec<Option<u8>> =
+                bytes.mutator_bytes().iter().copied().map(Some).collect();
+            *input = GeneralizedInputMetadata::generalized_from_options(&finished);
+        }
+        Ok(result)
+    }
+
+    fn post_exec(&mut self, state: &mut S, new_corpus_id: Option<CorpusId>) -> Result<(), Error> {
+        self.inner.post_exec(state, new_corpus_id)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use libafl_bolts::rands::StdRand;
+
+    use super::*;
+
+    fn text(bytes: &[u8]) -> Vec<u8> {
+        let mut rand = StdRand::with_seed(7);
+        let mut bytes = bytes.to_vec();
+        make_text(&mut rand, &mut bytes);
+        bytes
+    }
+
+    #[test]
+    fn valid_text_is_unchanged() {
+        for s in ["", "hello", "héllo wörld", "日本語", "emoji 🦀"] {
+            assert_eq!(text(s.as_bytes()), s.as_bytes());
+        }
+    }
+
+    #[test]
+    fn repairs_into_nul_free_utf8() {
+        let inputs: [&[u8]; 5] = [
+            b"a\0b",
+            b"\xff\xfe\xfd",
+            b"ok\xc3(ok",
+            b"cut \xe6\x97",
+            b"\0\xc3\xa9\0\x80",
+        ];
+        for input in inputs {
+            let out = text(input);
+            assert_eq!(out.len(), input.len());
+            assert!(core::str::from_utf8(&out).is_ok(), "{out:?}");
+            assert!(!out.contains(&0), "{out:?}");
+        }
+    }
+
+    #[test]
+    fn keeps_valid_sequences_around_repairs() {
+        let out = text(b"\xc3\xa9\xff\xc3\xa9");
+        assert_eq!(&out[..2], "é".as_bytes());
+        assert!((b' '..=b'~').contains(&out[2]));
+        assert_eq!(&out[3..], "é".as_bytes());
+    }
+}
@@ -0,0 +1,397 @@
+/// Objective feedbacks that bucket findings so each distinct bug reaches disk once.
+///
+/// Buckets are tracked on disk rather than in the fuzzer state: an in-process
+/// crash restarts the client, and every client of the launcher must agree on
+/// which bucket has already been written.
+use std::borrow::Cow;
+use std::cell::RefCell;
+use std::collections::{HashMap, HashSet};
+use std::fs::{self, OpenOptions};
+use std::io::{ErrorKind, Write};
+use std::path::{Path, PathBuf};
+use std::rc::Rc;
+use std::time::{Duration, Instant};
+
+use libafl::Error;
+use libafl::executors::ExitKind;
+use libafl::feedbacks::{Feedback, StateInitializer};
+use libafl::inputs::{BytesInput, HasTargetBytes};
+use libafl::observers::{BacktraceObserver, TimeObserver};
+use libafl_bolts::tuples::{Handle, Handled, MatchName, MatchNameRef};
+use libafl_bolts::{AsSlice, Named, hash_std};
+
+use crate::sanitizer_coverage::coverage_hash;
+
+/// Per-bucket hit files live here, relative to the objective directory.
+const BUCKETS_DIR: &str = ".buckets";
+/// Human-readable `<bucket> <hits>` summary, rewritten on new buckets and
+/// when buffered hits are flushed.
+const SUMMARY_FILE: &str = "buckets.txt";
+/// Little-endian `u64` hashes of every input that hit a hang bucket.
+const HANG_INPUTS_FILE: &str = ".hang_inputs";
+
+/// How long hits on buckets this client already knows stay in memory before
+/// they are appended to disk and the summary is rewritten.
+const FLUSH_INTERVAL: Duration = Duration::from_secs(1);
+
+/// Buckets this client has seen claimed, so repeat hits skip the filesystem.
+struct Claims {
+    /// Bucket hit file -> hits not yet appended to it.
+    unflushed: HashMap<PathBuf, u64>,
+    next_flush: Instant,
+}
+
+impl Claims {
+    fn new() -> Self {
+        Self {
+            unflushed: HashMap::new(),
+            next_flush: Instant::now() + FLUSH_INTERVAL,
+        }
+    }
+
+    fn flush_if_due(&mut self) {
+        let now = Instant::now();
+        if now >= self.next_flush {
+            self.next_flush = now + FLUSH_INTERVAL;
+            self.flush();
+        }
+    }
+
+    fn flush(&mut self) {
+        let mut dirs = HashSet::new();
+        for (path, hits) in &mut self.unflushed {
+            if *hits > 0 {
+                append_hits(path, core::mem::take(hits));
+                // `<dir>/.buckets/<bucket>` -> `<dir>`
+                if let Some(dir) = path.parent().and_then(Path::parent) {
+                    dirs.insert(dir.to_path_buf());
+                }
+            }
+        }
+        for dir in dirs {
+            write_summary(&dir);
+        }
+    }
+}
+
+thread_local! {
+    static CLAIMS: RefCell<Claims> = RefCell::new(Claims::new());
+}
+
+/// Record a hit for `bucket` under `dir`.
+///
+/// Each hit appends one byte to `dir/.buckets/<bucket>`, so the file length is
+/// the bucket's hit count across all clients. Returns true only for the hit
+/// that created the file, i.e. the first input seen for that bucket.
+///
+/// Once this client knows a bucket is taken, further hits on it are only
+/// counted in memory and written out every `FLUSH_INTERVAL` or by
+/// `flush_buckets`, so hit counts on disk may lag behind and miss the last
+/// few hits of a client that crashed.
+pub fn claim_bucket(dir: &Path, bucket: &str) -> bool {
+    let path = dir.join(BUCKETS_DIR).join(bucket);
+    CLAIMS.with_borrow_mut(|claims| {
+        if let Some(hits) = claims.unflushed.get_mut(&path) {
+            *hits += 1;
+            claims.flush_if_due();
+            return false;
+        }
+
+        if let Some(buckets) = path.parent() {
+            let _ = fs::create_dir_all(buckets);
+        }
+        let first = append_hits(&path, 1);
+        claims.unflushed.insert(path, 0);
+        write_summary(dir);
+        first
+    })
+}
+
+/// Write out hit counts still held in memory by `claim_bucket`.
+pub fn flush_buckets() {
+    CLAIMS.with_borrow_mut(Claims::flush);
+}
+
+/// Append `hits` bytes to a bucket hit file, creating it if needed. True if
+/// this call created it.
+fn append_hits(path: &Path, hits: u64) -> bool {
+    let (first, file) = match OpenOptions::new().append(true).create_new(true).open(path) {
+        Ok(file) => (true, Ok(file)),
+        Err(e) if e.kind() == ErrorKind::AlreadyExists => {
+            (false, OpenOptions::new().append(true).open(path))
+        }
+        Err(e) => (false, Err(e)),
+    };
+    if let Ok(mut file) = file {
+        let _ = file.write_all(&vec![b'.'; hits as usize]);
+    }
+    first
+}
+
+/// True if some client already recorded a hit for `bucket` under `dir`.
+///
+/// Buckets found claimed are remembered, so only unclaimed ones cost a stat.
+pub fn bucket_claimed(dir: &Path, bucket: &str) -> bool {
+    let path = dir.join(BUCKETS_DIR).join(bucket);
+    CLAIMS.with_borrow_mut(|claims| {
+        if claims.unflushed.contains_key(&path) {
+            return true;
+        }
+        let claimed = path.exists();
+        if claimed {
+            claims.unflushed.insert(path, 0);
+        }
+        claimed
+    })
+}
+
+/// Rewrite `dir/buckets.txt` from the per-bucket hit files, most hits first.
+fn write_summary(dir: &Path) {
+    let Ok(entries) = fs::read_dir(dir.join(BUCKETS_DIR)) else {
+        return;
+    };
+
+    let mut rows: Vec<(u64, String)> = entries
+        .filter_map(|entry| {
+            let entry = entry.ok()?;
+            let hits = entry.metadata().ok()?.len();
+            Some((hits, entry.file_name().to_string_lossy().into_owned()))
+        })
+        .collect();
+    rows.sort_by(|a, b| b.0.cmp(&a.0).then_with(|| a.1.cmp(&b.1)));
+
+    let mut out = String::from("# bucket hits\n");
+    for (hits, bucket) in rows {
+        out.push_str(&format!("{bucket} {hits}\n"));
+    }
+
+    // Write-then-rename so readers never observe a partial summary.
+    let tmp = dir.join(format!(".{SUMMARY_FILE}.{}", std::process::id()));
+    if fs::write(&tmp, out).is_ok() {
+        let _ = fs::rename(&tmp, dir.join(SUMMARY_FILE));
+    }
+}
+
+/// Keeps a crash only if it is the first one in its bucket.
+///
+/// The bucket is the backtrace hash captured by the `BacktraceObserver` in the
+/// crash handler, falling back to the coverage path hash when no backtrace
+/// could be taken.
+pub struct CrashBucketFeedback {
+    backtrace: Handle<BacktraceObserver<'static>>,
+    dir: PathBuf,
+}
+
+impl CrashBucketFeedback {
+    pub fn new(backtrace: &BacktraceObserver<'static>, dir: &str) -> Self {
+        Self {
+            backtrace: backtrace.handle(),
+            dir: PathBuf::from(dir),
+        }
+    }
+}
+
+impl Named for CrashBucketFeedback {
+    fn name(&self) -> &Cow<'static, str> {
+        static NAME: Cow<'static, str> = Cow::Borrowed("CrashBucketFeedback");
+        &NAME
+    }
+}
+
+impl<S> StateInitializer<S> for CrashBucketFeedback {}
+
+impl<EM, I, OT, S> Feedback<EM, I, OT, S> for CrashBucketFeedback
+where
+    OT: MatchName,
+{
+    fn is_interesting(
+        &mut self,
+        _state: &mut S,
+        _manager: &mut EM,
+        _input: &I,
+        observers: &OT,
+        exit_kind: &ExitKind,
+    ) -> Result<bool, Error> {
+        if *exit_kind != ExitKind::Crash {
+            return Ok(false);
+        }
+
+        let bucket = match observers.get(&self.backtrace).and_then(|o| o.hash()) {
+            Some(hash) => format!("stack-{hash:016x}"),
+            None => format!("cov-{:016x}", unsafe { coverage_hash() }),
+        };
+        Ok(claim_bucket(&self.dir, &bucket))
+    }
+}
+
+/// Keeps hangs out of the solutions corpus: the first input of each coverage
+/// bucket is written to the hang directory, and every hanging input's hash is
+/// recorded so `HangFilter` can reject it without waiting out the timeout.
+///
+/// Always returns false, so hangs never land in `crash_dir`.
+pub struct HangBucketFeedback {
+    dir: PathBuf,
+}
+
+impl HangBucketFeedback {
+    pub fn new(dir: &str) -> Self {
+        Self {
+            dir: PathBuf::from(dir),
+        }
+    }
+}
+
+impl Named for HangBucketFeedback {
+    fn name(&self) -> &Cow<'static, str> {
+        static NAME: Cow<'static, str> = Cow::Borrowed("HangBucketFeedback");
+        &NAME
+    }
+}
+
+impl<S> StateInitializer<S> for HangBucketFeedback {}
+
+impl<EM, I, OT, S> Feedback<EM, I, OT, S> for HangBucketFeedback
+where
+    I: HasTargetBytes,
+{
+    fn is_interesting(
+        &mut self,
+        _state: &mut S,
+        _manager: &mut EM,
+        input: &I,
+        _observers: &OT,
+        exit_kind: &ExitKind,
+    ) -> Result<bool, Error> {
+        if *exit_kind != ExitKind::Timeout {
+            return Ok(false);
+        }
+
+        record_hang(&self.dir, input.target_bytes().as_slice());
+        Ok(false)
+    }
+}
+
+/// Bucket a hanging input by coverage, write it to `dir` if its bucket is new,
+/// and record its hash for `HangFilter`.
+pub fn record_hang(dir: &Path, bytes: &[u8]) {
+    // Coverage at the moment of the timeout identifies where the target hung.
+    let bucket = format!("cov-{:016x}", unsafe { coverage_hash() });
+    if claim_bucket(dir, &bucket) {
+        let _ = fs::write(dir.join(&bucket), bytes);
+    }
+
+    if let Ok(mut file) = OpenOptions::new()
+        .create(true)
+        .append(true)
+        .open(dir.join(HANG_INPUTS_FILE))
+    {
+        let _ = file.write_all(&hash_std(bytes).to_le_bytes());
+    }
+}
+
+/// Most over-budget inputs waiting for confirmation at any time; more are
+/// dropped until the confirm stage catches up.
+const MAX_PENDING_SLOW: usize = 16;
+
+/// An over-budget run waiting to be confirmed, with its coverage bucket.
+pub type PendingSlow = Rc<RefCell<Vec<(BytesInput, String)>>>;
+
+/// Flags runs slower than the latency budget for confirmation.
+///
+/// A single slow run is often noise (preemption, page faults), so this only
+/// queues the input; `LatencyConfirmStage` re-runs it and reports it as an
+/// objective if it stays over budget. Inputs whose coverage bucket is already
+/// in the slow directory are skipped without re-running. Always returns false.
+pub struct LatencyBudgetFeedback {
+    time: Handle<TimeObserver>,
+    dir: PathBuf,
+    /// 0 = disabled.
+    budget_micros: u64,
+    pending: PendingSlow,
+}
+
+impl LatencyBudgetFeedback {
+    pub fn new(time: &TimeObserver, dir: &str, budget_micros: u64) -> Self {
+        Self {
+            time: time.handle(),
+            dir: PathBuf::from(dir),
+            budget_micros,
+            pending: Rc::default(),
+        }
+    }
+
+    /// Queue shared with `LatencyConfirmStage`.
+    pub fn pending(&self) -> PendingSlow {
+        Rc::clone(&self.pending)
+    }
+}
+
+impl Named for LatencyBudgetFeedback {
+    fn name(&self) -> &Cow<'static, str> {
+        static NAME: Cow<'static, str> = Cow::Borrowed("LatencyBudgetFeedback");
+        &NAME
+    }
+}
+
+impl<S> StateInitializer<S> for LatencyBudgetFeedback {}
+
+impl<EM, OT, S> Feedback<EM, BytesInput, OT, S> for LatencyBudgetFeedback
+where
+    OT: MatchName,
+{
+    fn is_interesting(
+        &mut self,
+        _state: &mut S,
+        _manager: &mut EM,
+        input: &BytesInput,
+        observers: &OT,
+        exit_kind: &ExitKind,
+    ) -> Result<bool, Error> {
+        if self.budget_micros == 0 || *exit_kind != ExitKind::Ok {
+            return Ok(false);
+        }
+        let Some(runtime) = observers.get(&self.time).and_then(|o| *o.last_runtime()) else {
+            return Ok(false);
+        };
+        if runtime.as_micros() as u64 <= self.budget_micros {
+            return Ok(false);
+        }
+
+        let bucket = format!("cov-{:016x}", unsafe { coverage_hash() });
+        let mut pending = self.pending.borrow_mut();
+        if pending.len() < MAX_PENDING_SLOW
+            && !pending.iter().any(|(_, queued)| *queued == bucket)
+            && !bucket_claimed(&self.dir, &bucket)
+        {
+            pending.push((input.clone(), bucket));
+        }
+        Ok(false)
+    }
+}
+
+/// Hashes of inputs known to hang, loaded from a hang directory.
+pub struct HangFilter {
+    hashes: HashSet<u64>,
+}
+
+impl HangFilter {
+    pub fn load(dir: &str) -> Self {
+        let hashes = fs::read(Path::new(dir).join(HANG_INPUTS_FILE))
+            .map(|raw| {
+                raw.chunks_exact(8)
+                    .map(|chunk| u64::from_le_bytes(chunk.try_into().unwrap()))
+                    .collect()
+            })
+            .unwrap_or_default();
+        Self { hashes }
+    }
+
+    /// True if `input` is byte-identical to one that already hung.
+    #[inline]
+    pub fn contains<I: HasTargetBytes>(&self, input: &I) -> bool {
+        !self.hashes.is_empty()
+            && self
+                .hashes
+                .contains(&hash_std(input.target_bytes().as_slice()))
+    }
+}
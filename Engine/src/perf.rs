@@ -0,0 +1,130 @@
+/// PERF mode: PerfFuzz-style search for inputs that maximize execution cost.
+///
+/// With `PERF_COUNTS` enabled, every run leaves a hit count per edge. An input
+/// is kept when it raises the highest count seen so far for any edge, so the
+/// corpus climbs toward the hottest path through each loop. Runs over the
+/// edge-hit budget are objectives, bucketed by coverage like hangs. Latency
+/// budgets go through `LatencyBudgetFeedback` in either mode.
+use std::borrow::Cow;
+use std::fs;
+use std::path::PathBuf;
+use std::ptr::addr_of;
+
+use libafl::Error;
+use libafl::executors::ExitKind;
+use libafl::feedbacks::{Feedback, StateInitializer};
+use libafl::inputs::HasTargetBytes;
+use libafl_bolts::{AsSlice, Named};
+
+use crate::objectives::claim_bucket;
+use crate::sanitizer_coverage::{MAP_SIZE, PERF_COUNTS, coverage_hash};
+
+/// Hit counts of the run that just finished.
+fn perf_counts() -> &'static [u32; MAP_SIZE] {
+    unsafe { &*addr_of!(PERF_COUNTS) }
+}
+
+/// Interesting when any edge was hit more often than in every earlier run of
+/// this client. Disabled outside PERF mode.
+pub struct MaxCountFeedback {
+    max_counts: Option<Box<[u32]>>,
+}
+
+impl MaxCountFeedback {
+    pub fn new(enabled: bool) -> Self {
+        Self {
+            max_counts: enabled.then(|| vec![0; MAP_SIZE].into_boxed_slice()),
+        }
+    }
+}
+
+impl Named for MaxCountFeedback {
+    fn name(&self) -> &Cow<'static, str> {
+        static NAME: Cow<'static, str> = Cow::Borrowed("MaxCountFeedback");
+        &NAME
+    }
+}
+
+impl<S> StateInitializer<S> for MaxCountFeedback {}
+
+impl<EM, I, OT, S> Feedback<EM, I, OT, S> for MaxCountFeedback {
+    fn is_interesting(
+        &mut self,
+        _state: &mut S,
+        _manager: &mut EM,
+        _input: &I,
+        _observers: &OT,
+        exit_kind: &ExitKind,
+    ) -> Result<bool, Error> {
+        let Some(max_counts) = self.max_counts.as_mut() else {
+            return Ok(false);
+        };
+        if *exit_kind != ExitKind::Ok {
+            return Ok(false);
+        }
+
+        let mut raised = false;
+        for (max, &count) in max_counts.iter_mut().zip(perf_counts()) {
+            if count > *max {
+                *max = count;
+                raised = true;
+            }
+        }
+        Ok(raised)
+    }
+}
+
+/// Objective for runs over the edge-hit budget: the first input of each
+/// coverage bucket is an objective and is also written to the perf directory,
+/// later ones only bump the bucket's hit count.
+pub struct PerfBudgetFeedback {
+    dir: PathBuf,
+    /// Total edge hits per run, a proxy for instructions. 0 = no budget.
+    budget_hits: u64,
+}
+
+impl PerfBudgetFeedback {
+    pub fn new(dir: &str, budget_hits: u64) -> Self {
+        Self {
+            dir: PathBuf::from(dir),
+            budget_hits,
+        }
+    }
+}
+
+impl Named for PerfBudgetFeedback {
+    fn name(&self) -> &Cow<'static, str> {
+        static NAME: Cow<'static, str> = Cow::Borrowed("PerfBudgetFeedback");
+        &NAME
+    }
+}
+
+impl<S> StateInitializer<S> for PerfBudgetFeedback {}
+
+impl<EM, I, OT, S> Feedback<EM, I, OT, S> for PerfBudgetFeedback
+where
+    I: HasTargetBytes,
+{
+    fn is_interesting(
+        &mut self,
+        _state: &mut S,
+        _manager: &mut EM,
+        input: &I,
+        _observers: &OT,
+        exit_kind: &ExitKind,
+    ) -> Result<bool, Error> {
+        if self.budget_hits == 0 || *exit_kind != ExitKind::Ok {
+            return Ok(false);
+        }
+        if perf_counts().iter().map(|&c| c as u64).sum::<u64>() <= self.budget_hits {
+            return Ok(false);
+        }
+
+        let bucket = format!("cov-{:016x}", unsafe { coverage_hash() });
+        if !claim_bucket(&self.dir, &bucket) {
+            return Ok(false);
+        }
+        let _ = fs::write(self.dir.join(&bucket), input.target_bytes().as_slice());
+        Ok(true)
+    }
+}
@@ -1,10 +1,19 @@
 use core::ptr::{addr_of_mut, write};
+#[cfg(feature = "introspection")]
+use core::sync::atomic::{AtomicU64, Ordering};
 
 pub const MAP_SIZE: usize = 65536;
 
 pub static mut SIGNALS: [u8; MAP_SIZE] = [0; MAP_SIZE];
 pub static mut SIGNALS_PTR: *mut u8 = core::ptr::null_mut();
 
+/// Per-edge hit counts of the current run, maintained only in PERF mode.
+#[cfg(feature = "std")]
+pub static mut PERF_COUNTS: [u32; MAP_SIZE] = [0; MAP_SIZE];
+/// Set once by `enable_perf_counts`; read on every edge.
+#[cfg(feature = "std")]
+static mut PERF_ENABLED: bool = false;
+
 /// Initialize the signals pointer. Must be called once before fuzzing.
 pub unsafe fn init_coverage() {
     unsafe {
@@ -12,20 +21,63 @@ pub unsafe fn init_coverage() {
     }
 }
 
+/// Count every edge hit into `PERF_COUNTS` from now on. Call before fuzzing.
+#[cfg(feature = "std")]
+pub unsafe fn enable_perf_counts() {
+    unsafe {
+        PERF_ENABLED = true;
+    }
+}
+
 /// Mark a coverage hit at the given index.
 #[inline(always)]
 pub unsafe fn mark_coverage(idx: usize) {
     unsafe {
         if idx < MAP_SIZE {
             write(SIGNALS_PTR.add(idx), 1);
+            #[cfg(feature = "std")]
+            if PERF_ENABLED {
+                let count = addr_of_mut!(PERF_COUNTS).cast::<u32>().add(idx);
+                write(count, (*count).wrapping_add(1));
+            }
         }
     }
 }
 
+/// Cycles this process spent in `reset_coverage` (introspection builds only).
+#[cfg(feature = "introspection")]
+pub static RESET_CYCLES: AtomicU64 = AtomicU64::new(0);
+
 /// Reset all coverage signals to zero between runs.
 pub unsafe fn reset_coverage() {
+    #[cfg(feature = "introspection")]
+    let start = libafl_bolts::cpu::read_time_counter();
     unsafe {
         core::ptr::write_bytes(SIGNALS_PTR, 0, MAP_SIZE);
+        #[cfg(feature = "std")]
+        if PERF_ENABLED {
+            core::ptr::write_bytes(addr_of_mut!(PERF_COUNTS).cast::<u32>(), 0, MAP_SIZE);
+        }
+    }
+    #[cfg(feature = "introspection")]
+    RESET_CYCLES.fetch_add(
+        libafl_bolts::cpu::read_time_counter() - start,
+        Ordering::Relaxed,
+    );
+}
+
+/// Hash of the current coverage map, used to bucket inputs by the path they took.
+pub unsafe fn coverage_hash() -> u64 {
+    unsafe {
+        let map = core::slice::from_raw_parts(SIGNALS_PTR, MAP_SIZE);
+        let mut hash = 0xcbf2_9ce4_8422_2325u64;
+        for (i, chunk) in map.chunks_exact(8).enumerate() {
+            let word = u64::from_ne_bytes(chunk.try_into().unwrap());
+            if word != 0 {
+                hash = (hash ^ word ^ (i as u64).rotate_left(32)).wrapping_mul(0x0100_0000_01b3);
+            }
+        }
+        hash
     }
 }
 
@@ -60,6 +112,9 @@ pub unsafe extern "C" fn __sanitizer_cov_trace_pc_guard(guard: *mut u32) {
         if idx == 0 {
             return;
         }
+        if crate::cmplog::recording() {
+            crate::cmplog::LAST_GUARD = idx as u32;
+        }
         mark_coverage(idx % MAP_SIZE);
     }
 }
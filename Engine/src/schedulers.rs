@@ -1,2 +1,48 @@
 /// Scheduler types re-exported for engine dispatch.
 pub use libafl::schedulers::StdWeightedScheduler;
+
+use libafl::Error;
+use libafl::corpus::Testcase;
+use libafl::feedbacks::MapIndexesMetadata;
+use libafl::schedulers::minimizer::MinimizerScheduler;
+use libafl::schedulers::powersched::PowerSchedule;
+use libafl::schedulers::testcase_score::TestcaseScore;
+use libafl::state::HasCorpus;
+use libafl_bolts::HasLen;
+
+use crate::config::SchedulerType;
+
+/// Minimizer that favors the smallest `len * exec time` per edge, with the
+/// time in nanoseconds. LibAFL's own score uses milliseconds, which rounds to
+/// 0 for most in-process targets and leaves only the length to compare.
+pub type IndexesLenTimeMinimizerScheduler<CS, I, O> =
+    MinimizerScheduler<CS, LenTimeNanosScore, I, MapIndexesMetadata, O>;
+
+/// `len * exec time in ns`; entries without a measured time count as 1 ns.
+#[derive(Debug, Clone)]
+pub struct LenTimeNanosScore;
+
+impl<I, S> TestcaseScore<I, S> for LenTimeNanosScore
+where
+    S: HasCorpus<I>,
+    I: HasLen,
+{
+    fn compute(state: &S, entry: &mut Testcase<I>) -> Result<f64, Error> {
+        let nanos = entry.exec_time().map_or(1, |d| d.as_nanos().max(1));
+        Ok(nanos as f64 * entry.load_len(state.corpus())? as f64)
+    }
+}
+
+/// AFLFast power schedule for a scheduler type, or `None` for the
+/// non-power schedulers.
+pub fn power_schedule(scheduler_type: SchedulerType) -> Option<PowerSchedule> {
+    match scheduler_type {
+        SchedulerType::Queue | SchedulerType::Weighted | SchedulerType::Minimized => None,
+        SchedulerType::Fast => Some(PowerSchedule::fast()),
+        SchedulerType::Explore => Some(PowerSchedule::explore()),
+        SchedulerType::Exploit => Some(PowerSchedule::exploit()),
+        SchedulerType::Coe => Some(PowerSchedule::coe()),
+        SchedulerType::Lin => Some(PowerSchedule::lin()),
+        SchedulerType::Quad => Some(PowerSchedule::quad()),
+    }
+}
@@ -0,0 +1,288 @@
+/// Non-blocking campaigns for the C API: start, poll stats, stop, join.
+///
+/// Every multicore run has a shared block; the session API only adds a handle
+/// to it from outside. The broker sets its stop flag when a stop policy fires.
+///
+/// `peel_fuzz_start` forks a session process that runs the launcher exactly
+/// like `peel_fuzz_run`, and returns to the caller at once. The caller and
+/// every fuzzer process below the session share one anonymous `MAP_SHARED`
+/// block: the broker's monitor publishes aggregate counters into it, and each
+/// client polls its stop flag in the main loop. Neither side takes a lock. The
+/// counters are written under a sequence number, so a reader retries instead
+/// of returning a torn snapshot.
+use core::ptr;
+use core::sync::atomic::{AtomicBool, AtomicPtr, AtomicU32, AtomicU64, Ordering, fence};
+
+use libafl::statistics::manager::ClientStatsManager;
+
+use crate::config::{PeelFuzzConfig, PeelFuzzStats};
+
+/// The block shared between the caller and the session's processes.
+#[derive(Default)]
+struct SharedBlock {
+    stop: AtomicU32,
+    running: AtomicU32,
+    /// Odd while the broker is writing the counters below.
+    seq: AtomicU64,
+    executions: AtomicU64,
+    /// `f64` bits.
+    execs_per_sec: AtomicU64,
+    corpus_count: AtomicU64,
+    objective_count: AtomicU64,
+    edges_hit: AtomicU64,
+    edges_total: AtomicU64,
+    run_time_sec: AtomicU64,
+    clients: AtomicU32,
+}
+
+/// Block of the session this process belongs to, null outside a session.
+/// Set in the session process before launching, so forked clients inherit it.
+static SHARED: AtomicPtr<SharedBlock> = AtomicPtr::new(ptr::null_mut());
+/// True when `SHARED` was mapped by `ensure_shared` for a single run rather
+/// than handed down by a session.
+static RUN_OWNED: AtomicBool = AtomicBool::new(false);
+
+/// Opaque handle returned by `peel_fuzz_start`.
+pub struct PeelFuzzSession {
+    pid: libc::pid_t,
+    shared: *mut SharedBlock,
+    /// Wait status, once the session process has been reaped.
+    status: Option<libc::c_int>,
+}
+
+/// Map a fresh block for a run started without a session handle. Must be
+/// called before the launcher forks its clients, and paired with
+/// `release_shared` once the launch returns.
+pub fn ensure_shared() {
+    if !SHARED.load(Ordering::Relaxed).is_null() {
+        return;
+    }
+    if let Some(shared) = map_block() {
+        SHARED.store(shared, Ordering::Relaxed);
+        RUN_OWNED.store(true, Ordering::Relaxed);
+    }
+}
+
+/// Unmap the block `ensure_shared` mapped, so the next run in this process
+/// starts without a stale stop flag or counters. A session's block is left
+/// to the session.
+pub fn release_shared() {
+    if RUN_OWNED.swap(false, Ordering::Relaxed) {
+        unmap_shared(SHARED.swap(ptr::null_mut(), Ordering::Relaxed));
+    }
+}
+
+fn map_block() -> Option<*mut SharedBlock> {
+    let shared = map_shared::<SharedBlock>()?;
+    unsafe { shared.write(SharedBlock::default()) };
+    Some(shared)
+}
+
+/// Map a zero-filled `T` that stays shared with every process forked after
+/// this call.
+pub fn map_shared<T>() -> Option<*mut T> {
+    unsafe {
+        let block = libc::mmap(
+            ptr::null_mut(),
+            size_of::<T>(),
+            libc::PROT_READ | libc::PROT_WRITE,
+            libc::MAP_SHARED | libc::MAP_ANONYMOUS,
+            -1,
+            0,
+        );
+        if block == libc::MAP_FAILED {
+            return None;
+        }
+        Some(block.cast::<T>())
+    }
+}
+
+/// Unmap a block from `map_shared`. Null is ignored.
+pub fn unmap_shared<T>(block: *mut T) {
+    if !block.is_null() {
+        unsafe { libc::munmap(block.cast(), size_of::<T>()) };
+    }
+}
+
+/// Tell every client of this run to stop.
+pub fn request_stop() {
+    let shared = SHARED.load(Ordering::Relaxed);
+    if !shared.is_null() {
+        unsafe { (*shared).stop.store(1, Ordering::Relaxed) };
+    }
+}
+
+/// True once a stop was requested by a session handle or the broker.
+#[inline]
+pub fn stop_requested() -> bool {
+    let shared = SHARED.load(Ordering::Relaxed);
+    !shared.is_null() && unsafe { (*shared).stop.load(Ordering::Relaxed) != 0 }
+}
+
+/// Publish the broker's aggregate stats to the shared block. Every multicore
+/// run has one, but only a session handle ever reads the counters.
+pub fn publish(stats: &mut ClientStatsManager) {
+    let shared = SHARED.load(Ordering::Relaxed);
+    if shared.is_null() {
+        return;
+    }
+    let shared = unsafe { &*shared };
+
+    let stats = crate::monitors::stats_snapshot(stats);
+
+    let seq = shared.seq.load(Ordering::Relaxed);
+    shared.seq.store(seq + 1, Ordering::Relaxed);
+    fence(Ordering::Release);
+    shared.executions.store(stats.executions, Ordering::Relaxed);
+    shared
+        .execs_per_sec
+        .store(stats.execs_per_sec.to_bits(), Ordering::Relaxed);
+    shared
+        .corpus_count
+        .store(stats.corpus_count, Ordering::Relaxed);
+    shared
+        .objective_count
+        .store(stats.objective_count, Ordering::Relaxed);
+    shared.edges_hit.store(stats.edges_hit, Ordering::Relaxed);
+    shared
+        .edges_total
+        .store(stats.edges_total, Ordering::Relaxed);
+    shared
+        .run_time_sec
+        .store(stats.run_time_sec, Ordering::Relaxed);
+    shared.clients.store(stats.clients, Ordering::Relaxed);
+    shared.seq.store(seq + 2, Ordering::Release);
+}
+
+/// Reads of the counters that may overlap a write before `snapshot` gives up.
+const SNAPSHOT_RETRIES: u32 = 1000;
+
+impl SharedBlock {
+    /// Consistent copy of the counters. A broker that died mid-write leaves
+    /// the sequence odd for good, so after `SNAPSHOT_RETRIES` torn reads the
+    /// last copy is returned as is.
+    fn snapshot(&self) -> PeelFuzzStats {
+        let mut retries = 0;
+        loop {
+            let before = self.seq.load(Ordering::Acquire);
+            let edges_hit = self.edges_hit.load(Ordering::Relaxed);
+            let edges_total = self.edges_total.load(Ordering::Relaxed);
+            let stats = PeelFuzzStats {
+                executions: self.executions.load(Ordering::Relaxed),
+                execs_per_sec: f64::from_bits(self.execs_per_sec.load(Ordering::Relaxed)),
+                corpus_count: self.corpus_count.load(Ordering::Relaxed),
+                objective_count: self.objective_count.load(Ordering::Relaxed),
+                edges_hit,
+                edges_total,
+                run_time_sec: self.run_time_sec.load(Ordering::Relaxed),
+                clients: self.clients.load(Ordering::Relaxed),
+                running: self.running.load(Ordering::Relaxed),
+                map_density: crate::monitors::map_density(edges_hit, edges_total),
+            };
+            fence(Ordering::Acquire);
+            if before % 2 == 0 && self.seq.load(Ordering::Relaxed) == before {
+                return stats;
+            }
+            retries += 1;
+            if retries >= SNAPSHOT_RETRIES {
+                return stats;
+            }
+            core::hint::spin_loop();
+        }
+    }
+}
+
+/// Start a campaign in the background. Returns NULL if the session process
+/// could not be created.
+///
+/// The session is forked from the caller, so `config` and everything it
+/// points to only has to stay valid until this call returns.
+///
+/// The fork is not followed by an exec, so the session process only has the
+/// calling thread. Call this from a single-threaded process: a lock held by
+/// any other thread at fork time (malloc's, stdio's, the caller's own) stays
+/// locked in the session forever and can deadlock it.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn peel_fuzz_start(config: *const PeelFuzzConfig) -> *mut PeelFuzzSession {
+    unsafe {
+        let Some(shared) = map_block() else {
+            return ptr::null_mut();
+        };
+        (*shared).running.store(1, Ordering::Release);
+
+        match libc::fork() {
+            -1 => {
+                libc::munmap(shared.cast(), size_of::<SharedBlock>());
+                ptr::null_mut()
+            }
+            0 => {
+                SHARED.store(shared, Ordering::Relaxed);
+                crate::peel_fuzz_run(config);
+                (*shared).running.store(0, Ordering::Release);
+                libc::_exit(0);
+            }
+            pid => Box::into_raw(Box::new(PeelFuzzSession {
+                pid,
+                shared,
+                status: None,
+            })),
+        }
+    }
+}
+
+/// Copy the campaign's current stats into `out`. Never blocks.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn peel_fuzz_stats(session: *mut PeelFuzzSession, out: *mut PeelFuzzStats) {
+    unsafe {
+        let session = &mut *session;
+        let mut stats = (*session.shared).snapshot();
+
+        // A session process that died never cleared `running` itself.
+        if session.status.is_none() {
+            let mut status = 0;
+            if libc::waitpid(session.pid, &mut status, libc::WNOHANG) == session.pid {
+                session.status = Some(status);
+            }
+        }
+        if session.status.is_some() {
+            stats.running = 0;
+        }
+        *out = stats;
+    }
+}
+
+/// Ask every client to finish its current run and exit. Returns at once;
+/// call `peel_fuzz_join` to wait for the campaign to wind down.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn peel_fuzz_stop(session: *mut PeelFuzzSession) {
+    unsafe { (*(*session).shared).stop.store(1, Ordering::Relaxed) };
+}
+
+/// Wait for the campaign to end and free the handle.
+///
+/// Returns the session process's exit code: 0 after a clean finish, 128 plus
+/// the signal number if it was killed, -1 if it could not be waited for.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn peel_fuzz_join(session: *mut PeelFuzzSession) -> i32 {
+    unsafe {
+        let session = Box::from_raw(session);
+        let status = session.status.or_else(|| {
+            loop {
+                let mut status = 0;
+                if libc::waitpid(session.pid, &mut status, 0) == session.pid {
+                    break Some(status);
+                }
+                if std::io::Error::last_os_error().kind() != std::io::ErrorKind::Interrupted {
+                    break None;
+                }
+            }
+        });
+        libc::munmap(session.shared.cast(), size_of::<SharedBlock>());
+
+        match status {
+            Some(s) if libc::WIFEXITED(s) => libc::WEXITSTATUS(s),
+            Some(s) if libc::WIFSIGNALED(s) => 128 + libc::WTERMSIG(s),
+            _ => -1,
+        }
+    }
+}
@@ -0,0 +1,772 @@
+/// Custom stages added alongside the mutational stage in the client loop.
+use std::borrow::Cow;
+use std::collections::HashSet;
+use std::marker::PhantomData;
+use std::num::NonZero;
+use std::path::PathBuf;
+use std::time::{Duration, Instant};
+
+use libafl::Error;
+use libafl::corpus::{Corpus, CorpusId, Testcase};
+use libafl::events::{Event, EventFirer};
+use libafl::executors::ExitKind;
+use libafl::fuzzer::{Evaluator, ExecutesInput, HasScheduler};
+use libafl::inputs::{BytesInput, HasMutatorBytes, HasTargetBytes};
+use libafl::mutators::{MutationResult, Mutator};
+use libafl::schedulers::RemovableScheduler;
+use libafl::stages::{Restartable, Stage};
+use libafl::state::{
+    HasCorpus, HasCurrentCorpusId, HasExecutions, HasMaxSize, HasRand, HasSolutions,
+};
+use libafl::statistics::user_stats::{AggregatorOps, UserStats, UserStatsValue};
+use libafl_bolts::AsSlice;
+use libafl_bolts::HasLen;
+use libafl_bolts::rands::Rand;
+
+use crate::cmplog::{self, CmpEntry};
+use crate::mutators::apply_fixup;
+use crate::objectives::{PendingSlow, claim_bucket};
+use crate::sanitizer_coverage::coverage_hash;
+use crate::targets::CFixupFn;
+
+/// AFL trim schedule: chunks start at 1/16 of the input and halve down to 1/1024.
+const TRIM_START_STEPS: usize = 16;
+const TRIM_END_STEPS: usize = 1024;
+const TRIM_MIN_BYTES: usize = 4;
+/// Runs of the original and the trimmed input each, averaged for exec speed.
+const TRIM_TIMING_RUNS: u32 = 4;
+
+/// Shrinks each corpus entry once, the first time it is scheduled, by removing
+/// chunks whose absence leaves the coverage map unchanged.
+///
+/// Trimming is capped at `budget_pct` percent of the client's wall-clock time,
+/// checked before every candidate run. Each candidate goes through the user's fixup first, so removing bytes does
+/// not break length fields or checksums. Bytes saved and the exec speed of
+/// trimmed entries before and after are reported as user stats. The entry's
+/// exec time is updated and the scheduler told of the replaced input, so
+/// time- and length-aware schedulers rank it by its trimmed form.
+pub struct TrimStage {
+    budget_pct: u32,
+    fixup: Option<CFixupFn>,
+    started: Instant,
+    spent: Duration,
+    trimmed: HashSet<CorpusId>,
+    bytes_saved: u64,
+    before: (u64, Duration),
+    after: (u64, Duration),
+}
+
+impl TrimStage {
+    pub fn new(budget_pct: u32, fixup: Option<CFixupFn>) -> Self {
+        Self {
+            budget_pct: budget_pct.min(100),
+            fixup,
+            started: Instant::now(),
+            spent: Duration::ZERO,
+            trimmed: HashSet::new(),
+            bytes_saved: 0,
+            before: (0, Duration::ZERO),
+            after: (0, Duration::ZERO),
+        }
+    }
+
+    /// `running` is time spent on the entry being trimmed, not yet in `spent`.
+    fn within_budget(&self, running: Duration) -> bool {
+        self.budget_pct > 0
+            && (self.spent + running) * 100 <= self.started.elapsed() * self.budget_pct
+    }
+
+    fn report<EM, S>(&self, state: &mut S, manager: &mut EM) -> Result<(), Error>
+    where
+        EM: EventFirer<BytesInput, S>,
+    {
+        let execs_per_sec =
+            |(runs, time): (u64, Duration)| runs as f64 / time.as_secs_f64().max(f64::EPSILON);
+
+        fire_stats(
+            state,
+            manager,
+            [
+                (
+                    "trim_bytes_saved",
+                    UserStatsValue::Number(self.bytes_saved),
+                    AggregatorOps::Sum,
+                ),
+                (
+                    "trim_execs_sec_before",
+                    UserStatsValue::Float(execs_per_sec(self.before)),
+                    AggregatorOps::Avg,
+                ),
+                (
+                    "trim_execs_sec_after",
+                    UserStatsValue::Float(execs_per_sec(self.after)),
+                    AggregatorOps::Avg,
+                ),
+            ],
+        )
+    }
+}
+
+/// Run `input`, returning its exit kind, coverage hash and run time.
+fn run_timed<E, EM, S, Z>(
+    fuzzer: &mut Z,
+    executor: &mut E,
+    state: &mut S,
+    manager: &mut EM,
+    input: &BytesInput,
+) -> Result<(ExitKind, u64, Duration), Error>
+where
+    Z: ExecutesInput<E, EM, BytesInput, S>,
+{
+    let start = Instant::now();
+    let exit_kind = fuzzer.execute_input(state, executor, manager, input)?;
+    let elapsed = start.elapsed();
+    Ok((exit_kind, unsafe { coverage_hash() }, elapsed))
+}
+
+/// Send each `(name, value, aggregation)` to the monitor as a user stat.
+fn fire_stats<EM, S, const N: usize>(
+    state: &mut S,
+    manager: &mut EM,
+    stats: [(&'static str, UserStatsValue, AggregatorOps); N],
+) -> Result<(), Error>
+where
+    EM: EventFirer<BytesInput, S>,
+{
+    for (name, value, op) in stats {
+        manager.fire(
+            state,
+            Event::UpdateUserStats {
+                name: Cow::Borrowed(name),
+                value: UserStats::new(value, op),
+                phantom: PhantomData,
+            },
+        )?;
+    }
+    Ok(())
+}
+
+impl<E, EM, S, Z> Stage<E, EM, S, Z> for TrimStage
+where
+    S: HasCorpus<BytesInput> + HasCurrentCorpusId,
+    Z: ExecutesInput<E, EM, BytesInput, S> + HasScheduler<BytesInput, S>,
+    Z::Scheduler: RemovableScheduler<BytesInput, S>,
+    EM: EventFirer<BytesInput, S>,
+{
+    fn perform(
+        &mut self,
+        fuzzer: &mut Z,
+        executor: &mut E,
+        state: &mut S,
+        manager: &mut EM,
+    ) -> Result<(), Error> {
+        if !self.within_budget(Duration::ZERO) {
+            return Ok(());
+        }
+        let Some(id) = state.current_corpus_id()? else {
+            return Ok(());
+        };
+        if !self.trimmed.insert(id) {
+            return Ok(());
+        }
+
+        let trim_start = Instant::now();
+        let original = state.corpus().cloned_input_for_id(id)?;
+        let mut best = original.target_bytes().as_slice().to_vec();
+
+        let (exit_kind, target_hash, _) = run_timed(fuzzer, executor, state, manager, &original)?;
+        if exit_kind != ExitKind::Ok || best.len() <= TRIM_MIN_BYTES {
+            self.spent += trim_start.elapsed();
+            return Ok(());
+        }
+
+        let len_p2 = best.len().next_power_of_two();
+        let mut remove_len = (len_p2 / TRIM_START_STEPS).max(TRIM_MIN_BYTES);
+        let end_len = (len_p2 / TRIM_END_STEPS).max(TRIM_MIN_BYTES);
+
+        'trim: while remove_len >= end_len {
+            let mut remove_pos = remove_len;
+            while remove_pos < best.len() {
+                // Out of budget: keep what was removed so far.
+                if !self.within_budget(trim_start.elapsed()) {
+                    break 'trim;
+                }
+                let trim_avail = remove_len.min(best.len() - remove_pos);
+                let mut candidate = Vec::with_capacity(best.len() - trim_avail);
+                candidate.extend_from_slice(&best[..remove_pos]);
+                candidate.extend_from_slice(&best[remove_pos + trim_avail..]);
+                apply_fixup(self.fixup, &mut candidate);
+
+                let candidate = BytesInput::new(candidate);
+                let (exit_kind, hash, _) = run_timed(fuzzer, executor, state, manager, &candidate)?;
+                if exit_kind == ExitKind::Ok && hash == target_hash {
+                    best = candidate.target_bytes().as_slice().to_vec();
+                } else {
+                    remove_pos += remove_len;
+                }
+            }
+            remove_len >>= 1;
+        }
+
+        let saved = original.target_bytes().as_slice().len() - best.len();
+        if saved > 0 {
+            let trimmed = BytesInput::new(best);
+            // Interleaved, so drift in machine load hits both sides alike.
+            let (mut before_time, mut after_time) = (Duration::ZERO, Duration::ZERO);
+            for _ in 0..TRIM_TIMING_RUNS {
+                before_time += run_timed(fuzzer, executor, state, manager, &original)?.2;
+                after_time += run_timed(fuzzer, executor, state, manager, &trimmed)?.2;
+            }
+
+            self.bytes_saved += saved as u64;
+            let runs = u64::from(TRIM_TIMING_RUNS);
+            self.before = (self.before.0 + runs, self.before.1 + before_time);
+            self.after = (self.after.0 + runs, self.after.1 + after_time);
+
+            let mut testcase = state.corpus().get(id)?.borrow_mut();
+            let prev = testcase.clone();
+            testcase.set_input(trimmed);
+            testcase.set_exec_time(after_time / TRIM_TIMING_RUNS);
+            drop(testcase);
+            // Let the scheduler re-score the entry, e.g. the minimizer's
+            // favored set, which ranks by length and exec time.
+            fuzzer.scheduler_mut().on_replace(state, id, &prev)?;
+            self.report(state, manager)?;
+        }
+
+        self.spent += trim_start.elapsed();
+        Ok(())
+    }
+}
+
+impl<S> Restartable<S> for TrimStage {
+    fn should_restart(&mut self, _state: &mut S) -> Result<bool, Error> {
+        Ok(true)
+    }
+
+    fn clear_progress(&mut self, _state: &mut S) -> Result<(), Error> {
+        Ok(())
+    }
+}
+
+/// Mutated inputs tried per checksum stage run.
+const CHECKSUM_STAGE_ITERS: usize = 32;
+/// Single-byte perturbations used to tell checksums from constant checks.
+const CHECKSUM_PROBES: usize = 4;
+/// Repair rounds per input, enough for checksums computed over other checksums.
+const MAX_REPAIR_ROUNDS: usize = 4;
+
+/// A comparison with one operand read verbatim from the input at `offset` and
+/// the other computed from the rest of the input, e.g. `hdr.crc != crc16(payload)`.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+struct ChecksumSite {
+    site: u32,
+    stored_is_a: bool,
+    offset: usize,
+    width: usize,
+    big_endian: bool,
+}
+
+impl ChecksumSite {
+    /// Split a logged comparison into (stored, computed) operands.
+    fn operands(&self, entry: &CmpEntry) -> (u64, u64) {
+        if self.stored_is_a {
+            (entry.a, entry.b)
+        } else {
+            (entry.b, entry.a)
+        }
+    }
+}
+
+fn encode(value: u64, width: usize, big_endian: bool) -> Vec<u8> {
+    if big_endian {
+        value.to_be_bytes()[8 - width..].to_vec()
+    } else {
+        value.to_le_bytes()[..width].to_vec()
+    }
+}
+
+/// Smallest comparison width that holds `value`.
+fn operand_width(value: u64) -> usize {
+    match value {
+        0..=0xff => 1,
+        0x100..=0xffff => 2,
+        0x1_0000..=0xffff_ffff => 4,
+        _ => 8,
+    }
+}
+
+/// Finds checksum comparisons from trace-cmp logs and repairs inputs so they
+/// pass them, in the style of TaintScope and Redqueen.
+///
+/// Each corpus entry is analysed once: a comparison whose operands differ is a
+/// checksum if one operand occurs exactly once in the input and stays fixed
+/// when other bytes are flipped, while the other operand changes. The stage
+/// then mutates the entry, writes the computed operand over the stored field
+/// of each candidate, and evaluates the repaired input as usual, so saved
+/// corpus entries and crashes pass the real check.
+///
+/// Compare hooks cannot change the branch taken, so instead of running a
+/// patched target first, each candidate is repaired before its real run.
+pub struct ChecksumStage<M> {
+    mutator: M,
+    sites: HashSet<ChecksumSite>,
+    analysed: HashSet<CorpusId>,
+    repairs: u64,
+}
+
+impl<M> ChecksumStage<M> {
+    pub fn new(mutator: M) -> Self {
+        Self {
+            mutator,
+            sites: HashSet::new(),
+            analysed: HashSet::new(),
+            repairs: 0,
+        }
+    }
+
+    /// Run `input` with comparison logging switched on.
+    fn run_logged<E, EM, S, Z>(
+        fuzzer: &mut Z,
+        executor: &mut E,
+        state: &mut S,
+        manager: &mut EM,
+        input: &BytesInput,
+    ) -> Result<Vec<CmpEntry>, Error>
+    where
+        Z: ExecutesInput<E, EM, BytesInput, S>,
+    {
+        unsafe { cmplog::start() };
+        let result = fuzzer.execute_input(state, executor, manager, input);
+        let log = unsafe { cmplog::stop() }.to_vec();
+        result?;
+        Ok(log)
+    }
+
+    /// Look for new checksum sites in `input`. Returns how many were found.
+    fn detect<E, EM, S, Z>(
+        &mut self,
+        fuzzer: &mut Z,
+        executor: &mut E,
+        state: &mut S,
+        manager: &mut EM,
+        input: &BytesInput,
+    ) -> Result<usize, Error>
+    where
+        S: HasRand,
+        Z: ExecutesInput<E, EM, BytesInput, S>,
+    {
+        let bytes = input.target_bytes().as_slice().to_vec();
+        let Some(len) = NonZero::new(bytes.len()) else {
+            return Ok(0);
+        };
+        let log = Self::run_logged(fuzzer, executor, state, manager, input)?;
+        let before = self.sites.len();
+
+        for _ in 0..CHECKSUM_PROBES {
+            let probe = state.rand_mut().below(len);
+            let mut perturbed = bytes.clone();
+            perturbed[probe] ^= 0xff;
+            let probe_log = Self::run_logged(
+                fuzzer,
+                executor,
+                state,
+                manager,
+                &BytesInput::new(perturbed),
+            )?;
+
+            for entry in log.iter().filter(|e| e.a != e.b) {
+                let Some(probed) = probe_log.iter().find(|p| p.site == entry.site) else {
+                    continue;
+                };
+
+                for stored_is_a in [true, false] {
+                    let mut site = ChecksumSite {
+                        site: entry.site,
+                        stored_is_a,
+                        offset: 0,
+                        width: 0,
+                        big_endian: false,
+                    };
+                    let (stored, computed) = site.operands(entry);
+                    let (probed_stored, probed_computed) = site.operands(probed);
+                    if probed_stored != stored || probed_computed == computed {
+                        continue;
+                    }
+
+                    site.width = operand_width(stored.max(computed)).min(entry.width as usize);
+                    for big_endian in [false, true] {
+                        let needle = encode(stored, site.width, big_endian);
+                        let mut hits = bytes
+                            .windows(site.width)
+                            .enumerate()
+                            .filter(|(_, w)| *w == needle.as_slice())
+                            .map(|(i, _)| i);
+                        if let (Some(offset), None) = (hits.next(), hits.next()) {
+                            if !(offset..offset + site.width).contains(&probe) {
+                                site.offset = offset;
+                                site.big_endian = big_endian;
+                                self.sites.insert(site);
+                            }
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        Ok(self.sites.len() - before)
+    }
+
+    /// Overwrite stored checksum fields of `input` with the values the target
+    /// computed. Returns true if any field was changed.
+    fn repair<E, EM, S, Z>(
+        &mut self,
+        fuzzer: &mut Z,
+        executor: &mut E,
+        state: &mut S,
+        manager: &mut EM,
+        input: &mut BytesInput,
+    ) -> Result<bool, Error>
+    where
+        Z: ExecutesInput<E, EM, BytesInput, S>,
+    {
+        let mut repaired = false;
+        for _ in 0..MAX_REPAIR_ROUNDS {
+            let log = Self::run_logged(fuzzer, executor, state, manager, input)?;
+            let bytes = input.mutator_bytes_mut();
+
+            let mut changed = false;
+            for site in &self.sites {
+                let Some(entry) = log.iter().find(|e| e.site == site.site) else {
+                    continue;
+                };
+                let (stored, computed) = site.operands(entry);
+                let end = site.offset + site.width;
+                if stored == computed || end > bytes.len() {
+                    continue;
+                }
+                let field = &mut bytes[site.offset..end];
+                if *field != *encode(stored, site.width, site.big_endian) {
+                    continue;
+                }
+                field.copy_from_slice(&encode(computed, site.width, site.big_endian));
+                changed = true;
+            }
+
+            if !changed {
+                break;
+            }
+            repaired = true;
+        }
+
+        if repaired {
+            self.repairs += 1;
+        }
+        Ok(repaired)
+    }
+}
+
+impl<E, EM, M, S, Z> Stage<E, EM, S, Z> for ChecksumStage<M>
+where
+    S: HasCorpus<BytesInput> + HasCurrentCorpusId + HasRand,
+    Z: ExecutesInput<E, EM, BytesInput, S> + Evaluator<E, EM, BytesInput, S>,
+    EM: EventFirer<BytesInput, S>,
+    M: Mutator<BytesInput, S>,
+{
+    fn perform(
+        &mut self,
+        fuzzer: &mut Z,
+        executor: &mut E,
+        state: &mut S,
+        manager: &mut EM,
+    ) -> Result<(), Error> {
+        let Some(id) = state.current_corpus_id()? else {
+            return Ok(());
+        };
+        let base = state.corpus().cloned_input_for_id(id)?;
+        let (sites_before, repairs_before) = (self.sites.len(), self.repairs);
+
+        if self.analysed.insert(id) && self.detect(fuzzer, executor, state, manager, &base)? > 0 {
+            let mut input = base.clone();
+            if self.repair(fuzzer, executor, state, manager, &mut input)? {
+                fuzzer.evaluate_input(state, executor, manager, &input)?;
+            }
+        }
+
+        if !self.sites.is_empty() {
+            for _ in 0..CHECKSUM_STAGE_ITERS {
+                let mut input = base.clone();
+                if self.mutator.mutate(state, &mut input)? == MutationResult::Skipped {
+                    continue;
+                }
+                // Unrepaired candidates add nothing over the regular havoc stage.
+                if self.repair(fuzzer, executor, state, manager, &mut input)? {
+                    let (_, corpus_id) = fuzzer.evaluate_input(state, executor, manager, &input)?;
+                    self.mutator.post_exec(state, corpus_id)?;
+                }
+            }
+        }
+
+        if (self.sites.len(), self.repairs) != (sites_before, repairs_before) {
+            fire_stats(
+                state,
+                manager,
+                [
+                    (
+                        "checksum_sites",
+                        UserStatsValue::Number(self.sites.len() as u64),
+                        AggregatorOps::Max,
+                    ),
+                    (
+                        "checksum_repairs",
+                        UserStatsValue::Number(self.repairs),
+                        AggregatorOps::Sum,
+                    ),
+                ],
+            )?;
+        }
+        Ok(())
+    }
+}
+
+impl<M, S> Restartable<S> for ChecksumStage<M> {
+    fn should_restart(&mut self, _state: &mut S) -> Result<bool, Error> {
+        Ok(true)
+    }
+
+    fn clear_progress(&mut self, _state: &mut S) -> Result<(), Error> {
+        Ok(())
+    }
+}
+
+/// Smallest starting cap, as in libFuzzer.
+const LEN_CONTROL_MIN_CAP: usize = 4;
+
+/// libFuzzer-style `-len_control`: the length cap starts at the largest
+/// corpus entry and grows by log2(cap) whenever `runs_per_log` × log2(cap)
+/// executions pass without a new corpus entry, up to `max_len`.
+///
+/// The cap is the state's max size, which havoc respects when growing inputs
+/// and `LenCapMutator` enforces on every mutated input.
+pub struct LenControlStage {
+    runs_per_log: u64,
+    max_len: usize,
+    cap: usize,
+    corpus_count: usize,
+    last_update: u64,
+}
+
+impl LenControlStage {
+    /// `runs_per_log` = 0 leaves the cap at `max_len`.
+    pub fn new(runs_per_log: u32, max_len: usize) -> Self {
+        Self {
+            runs_per_log: runs_per_log as u64,
+            max_len,
+            cap: 0,
+            corpus_count: 0,
+            last_update: 0,
+        }
+    }
+}
+
+impl<E, EM, S, Z> Stage<E, EM, S, Z> for LenControlStage
+where
+    S: HasCorpus<BytesInput> + HasMaxSize + HasExecutions,
+    EM: EventFirer<BytesInput, S>,
+{
+    fn perform(
+        &mut self,
+        _fuzzer: &mut Z,
+        _executor: &mut E,
+        state: &mut S,
+        manager: &mut EM,
+    ) -> Result<(), Error> {
+        if self.runs_per_log == 0 || (self.cap != 0 && self.cap >= self.max_len) {
+            return Ok(());
+        }
+        let executions = *state.executions();
+
+        if self.cap == 0 {
+            let mut longest = LEN_CONTROL_MIN_CAP;
+            for id in state.corpus().ids() {
+                if let Some(input) = state.corpus().get(id)?.borrow().input() {
+                    longest = longest.max(input.len());
+                }
+            }
+            self.cap = longest.min(self.max_len);
+            self.corpus_count = state.corpus().count();
+            self.last_update = executions;
+        } else if state.corpus().count() != self.corpus_count {
+            self.corpus_count = state.corpus().count();
+            self.last_update = executions;
+            return Ok(());
+        } else {
+            let log = self.cap.ilog2() as u64;
+            if executions - self.last_update <= self.runs_per_log * log {
+                return Ok(());
+            }
+            self.cap = (self.cap + log as usize).min(self.max_len);
+            self.last_update = executions;
+        }
+
+        state.set_max_size(self.cap);
+        fire_stats(
+            state,
+            manager,
+            [(
+                "len_cap",
+                UserStatsValue::Number(self.cap as u64),
+                AggregatorOps::Max,
+            )],
+        )
+    }
+}
+
+impl<S> Restartable<S> for LenControlStage {
+    fn should_restart(&mut self, _state: &mut S) -> Result<bool, Error> {
+        Ok(true)
+    }
+
+    fn clear_progress(&mut self, _state: &mut S) -> Result<(), Error> {
+        Ok(())
+    }
+}
+
+/// Re-runs before an over-budget input counts as slow.
+const LATENCY_CONFIRM_RUNS: usize = 3;
+
+/// Confirms inputs queued by `LatencyBudgetFeedback`: each is re-run
+/// `LATENCY_CONFIRM_RUNS` times and kept only if even its fastest run is over
+/// the budget. The first confirmed input of each coverage bucket becomes an
+/// objective, like a crash, and is also written to the slow directory; the
+/// total is reported as the `latency_confirmed` user stat.
+pub struct LatencyConfirmStage {
+    pending: PendingSlow,
+    dir: PathBuf,
+    budget: Duration,
+    confirmed: u64,
+}
+
+impl LatencyConfirmStage {
+    pub fn new(pending: PendingSlow, dir: &str, budget_micros: u64) -> Self {
+        Self {
+            pending,
+            dir: PathBuf::from(dir),
+            budget: Duration::from_micros(budget_micros),
+            confirmed: 0,
+        }
+    }
+}
+
+impl<E, EM, S, Z> Stage<E, EM, S, Z> for LatencyConfirmStage
+where
+    S: HasSolutions<BytesInput>,
+    Z: ExecutesInput<E, EM, BytesInput, S>,
+    EM: EventFirer<BytesInput, S>,
+{
+    fn perform(
+        &mut self,
+        fuzzer: &mut Z,
+        executor: &mut E,
+        state: &mut S,
+        manager: &mut EM,
+    ) -> Result<(), Error> {
+        let pending = std::mem::take(&mut *self.pending.borrow_mut());
+        if pending.is_empty() {
+            return Ok(());
+        }
+
+        let confirmed_before = self.confirmed;
+        'inputs: for (input, bucket) in pending {
+            for _ in 0..LATENCY_CONFIRM_RUNS {
+                let (exit_kind, _, elapsed) = run_timed(fuzzer, executor, state, manager, &input)?;
+                if exit_kind != ExitKind::Ok || elapsed <= self.budget {
+                    continue 'inputs;
+                }
+            }
+            if claim_bucket(&self.dir, &bucket) {
+                let _ = std::fs::write(self.dir.join(&bucket), input.target_bytes().as_slice());
+                state.solutions_mut().add(Testcase::new(input))?;
+                manager.fire(
+                    state,
+                    Event::Objective {
+                        objective_size: state.solutions().count(),
+                        time: libafl_bolts::current_time(),
+                    },
+                )?;
+                self.confirmed += 1;
+            }
+        }
+
+        if self.confirmed == confirmed_before {
+            return Ok(());
+        }
+        fire_stats(
+            state,
+            manager,
+            [(
+                "latency_confirmed",
+                UserStatsValue::Number(self.confirmed),
+                AggregatorOps::Sum,
+            )],
+        )
+    }
+}
+
+impl<S> Restartable<S> for LatencyConfirmStage {
+    fn should_restart(&mut self, _state: &mut S) -> Result<bool, Error> {
+        Ok(true)
+    }
+
+    fn clear_progress(&mut self, _state: &mut S) -> Result<(), Error> {
+        Ok(())
+    }
+}
+
+/// The havoc stage of a client: plain, or power-scheduled when the scheduler
+/// assigns energy. Both wrap the same mutator type and only one is built, so
+/// MOpt's state metadata is installed once.
+pub enum HavocStage<P, W> {
+    Plain(P),
+    Power(W),
+}
+
+impl<E, EM, P, S, W, Z> Stage<E, EM, S, Z> for HavocStage<P, W>
+where
+    P: Stage<E, EM, S, Z>,
+    W: Stage<E, EM, S, Z>,
+{
+    fn perform(
+        &mut self,
+        fuzzer: &mut Z,
+        executor: &mut E,
+        state: &mut S,
+        manager: &mut EM,
+    ) -> Result<(), Error> {
+        match self {
+            Self::Plain(stage) => stage.perform(fuzzer, executor, state, manager),
+            Self::Power(stage) => stage.perform(fuzzer, executor, state, manager),
+        }
+    }
+}
+
+impl<P, S, W> Restartable<S> for HavocStage<P, W>
+where
+    P: Restartable<S>,
+    W: Restartable<S>,
+{
+    fn should_restart(&mut self, state: &mut S) -> Result<bool, Error> {
+        match self {
+            Self::Plain(stage) => stage.should_restart(state),
+            Self::Power(stage) => stage.should_restart(state),
+        }
+    }
+
+    fn clear_progress(&mut self, state: &mut S) -> Result<(), Error> {
+        match self {
+            Self::Plain(stage) => stage.clear_progress(state),
+            Self::Power(stage) => stage.clear_progress(state),
+        }
+    }
+}
@@ -0,0 +1,151 @@
+/// AFL-style machine-readable stats, written by the broker.
+///
+/// `fuzzer_stats` holds the latest `key : value` snapshot and is replaced
+/// atomically, so readers never see a partial file. `plot_data` is a CSV
+/// started afresh by each run, with one row per interval, for graphing
+/// throughput and coverage over time. The last snapshot is written when the
+/// broker shuts down, even mid-interval. Both are derived from the client
+/// stats the broker already receives; clients do no extra work.
+use std::fmt::Write as _;
+use std::fs::{self, OpenOptions};
+use std::io::Write as _;
+use std::path::PathBuf;
+use std::time::{Duration, Instant, SystemTime, UNIX_EPOCH};
+
+use libafl::statistics::manager::ClientStatsManager;
+
+const STATS_FILE: &str = "fuzzer_stats";
+const PLOT_FILE: &str = "plot_data";
+const PLOT_HEADER: &str = "# relative_time, execs_done, execs_per_sec, corpus_count, saved_crashes, edges_found, map_density\n";
+
+/// Rendered `fuzzer_stats` contents and `plot_data` row.
+struct Snapshot {
+    stats: String,
+    row: String,
+}
+
+pub struct StatsFiles {
+    dir: PathBuf,
+    interval: Duration,
+    start_time: u64,
+    next_write: Instant,
+    /// Latest snapshot not yet written, flushed on drop.
+    unwritten: Option<Snapshot>,
+}
+
+impl StatsFiles {
+    /// Write into `dir` at most once per `interval`. `plot_data` is truncated
+    /// so it only holds this run's rows.
+    pub fn new(dir: &str, interval: Duration) -> Self {
+        let dir = PathBuf::from(dir);
+        let _ = fs::create_dir_all(&dir);
+        let _ = fs::write(dir.join(PLOT_FILE), PLOT_HEADER);
+        Self {
+            dir,
+            interval,
+            start_time: unix_time(),
+            next_write: Instant::now(),
+            unwritten: None,
+        }
+    }
+
+    /// Rewrite `fuzzer_stats` and append a `plot_data` row if the interval
+    /// has passed; otherwise keep the snapshot for the final write.
+    pub fn update(&mut self, stats: &mut ClientStatsManager) {
+        let snapshot = self.render(stats);
+        let now = Instant::now();
+        if now < self.next_write {
+            self.unwritten = Some(snapshot);
+            return;
+        }
+        self.next_write = now + self.interval;
+        self.unwritten = None;
+        self.write(&snapshot);
+    }
+
+    fn render(&self, stats: &mut ClientStatsManager) -> Snapshot {
+        let (edges_found, total_edges) = crate::monitors::edges(stats);
+        let density = crate::monitors::map_density(edges_found, total_edges);
+        let global = stats.global_stats();
+
+        let mut out = String::new();
+        let _ = write!(
+            out,
+            "start_time        : {}\n\
+             last_update       : {}\n\
+             run_time          : {}\n\
+             fuzzer_pid        : {}\n\
+             clients           : {}\n\
+             execs_done        : {}\n\
+             execs_per_sec     : {:.2}\n\
+             corpus_count      : {}\n\
+             saved_crashes     : {}\n\
+             edges_found       : {}\n\
+             total_edges       : {}\n\
+             bitmap_cvg        : {:.2}%\n",
+            self.start_time,
+            unix_time(),
+            global.run_time.as_secs(),
+            std::process::id(),
+            global.client_stats_count,
+            global.total_execs,
+            global.execs_per_sec,
+            global.corpus_size,
+            global.objective_size,
+            edges_found,
+            total_edges,
+            density,
+        );
+        if let Some(times) = crate::exec_time::ExecTimes::merged() {
+            let _ = write!(
+                out,
+                "exec_us_p50       : {}\n\
+                 exec_us_p99       : {}\n\
+                 exec_us_p999      : {}\n",
+                times.percentile(0.5),
+                times.percentile(0.99),
+                times.percentile(0.999),
+            );
+        }
+
+        let row = format!(
+            "{}, {}, {:.2}, {}, {}, {}, {:.2}%\n",
+            global.run_time.as_secs(),
+            global.total_execs,
+            global.execs_per_sec,
+            global.corpus_size,
+            global.objective_size,
+            edges_found,
+            density,
+        );
+        Snapshot { stats: out, row }
+    }
+
+    fn write(&self, snapshot: &Snapshot) {
+        // Write-then-rename so readers never observe a partial file.
+        let tmp = self.dir.join(format!(".{STATS_FILE}.tmp"));
+        if fs::write(&tmp, &snapshot.stats).is_ok() {
+            let _ = fs::rename(&tmp, self.dir.join(STATS_FILE));
+        }
+
+        let path = self.dir.join(PLOT_FILE);
+        if let Ok(mut file) = OpenOptions::new().create(true).append(true).open(&path) {
+            let _ = file.write_all(snapshot.row.as_bytes());
+        }
+    }
+}
+
+// The broker's monitor, and with it this, is dropped when the launch returns.
+impl Drop for StatsFiles {
+    fn drop(&mut self) {
+        if let Some(snapshot) = self.unwritten.take() {
+            self.write(&snapshot);
+        }
+    }
+}
+
+fn unix_time() -> u64 {
+    SystemTime::now()
+        .duration_since(UNIX_EPOCH)
+        .map_or(0, |d| d.as_secs())
+}
@@ -0,0 +1,201 @@
+/// Per-core strategy plans for the multicore launcher.
+///
+/// A plan is a compact spec string of `<cores>=<strategy>` entries separated
+/// by commas, for example `"0=explore,1-3=queue+mopt,4-=weighted"`:
+///
+/// - `<cores>` is a client index `N`, a range `N-M`, an open range `N-`, or `*`.
+/// - `<strategy>` is a scheduler name (`queue`, `weighted`, `minimized`, `fast`,
+///   `explore`, `exploit`, `coe`, `lin`, `quad`) optionally followed by a
+///   mutator (`+havoc` or `+mopt`).
+///
+/// The first matching entry wins; clients no entry matches use the config's
+/// `scheduler_type` and `mutator_type`.
+use core::fmt;
+
+use crate::config::{MutatorType, SchedulerType};
+
+/// Scheduler and mutator run by one client.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct Strategy {
+    pub scheduler: SchedulerType,
+    pub mutator: MutatorType,
+}
+
+impl fmt::Display for Strategy {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        let scheduler = SCHEDULER_NAMES
+            .iter()
+            .find(|(_, t)| *t == self.scheduler)
+            .map_or("?", |(name, _)| name);
+        let mutator = match self.mutator {
+            MutatorType::Havoc => "havoc",
+            MutatorType::MOpt => "mopt",
+        };
+        write!(f, "{scheduler}+{mutator}")
+    }
+}
+
+const SCHEDULER_NAMES: [(&str, SchedulerType); 9] = [
+    ("queue", SchedulerType::Queue),
+    ("weighted", SchedulerType::Weighted),
+    ("minimized", SchedulerType::Minimized),
+    ("fast", SchedulerType::Fast),
+    ("explore", SchedulerType::Explore),
+    ("exploit", SchedulerType::Exploit),
+    ("coe", SchedulerType::Coe),
+    ("lin", SchedulerType::Lin),
+    ("quad", SchedulerType::Quad),
+];
+
+#[derive(Debug, Clone, Copy)]
+struct Entry {
+    first: usize,
+    last: Option<usize>,
+    strategy: Strategy,
+}
+
+/// Ordered list of client ranges and the strategy each one runs.
+#[derive(Debug, Clone, Default)]
+pub struct StrategyPlan {
+    entries: Vec<Entry>,
+}
+
+impl StrategyPlan {
+    /// Parse a plan spec. An empty spec yields an empty plan.
+    pub fn parse(spec: &str) -> Result<Self, String> {
+        let mut entries = Vec::new();
+
+        for item in spec.split(',').map(str::trim).filter(|s| !s.is_empty()) {
+            let (cores, strategy) = item
+                .split_once('=')
+                .ok_or_else(|| format!("strategy plan entry `{item}` is missing `=`"))?;
+
+            let (first, last) = match cores.trim() {
+                "*" => (0, None),
+                range => match range.split_once('-') {
+                    Some((a, "")) => (parse_index(a)?, None),
+                    Some((a, b)) => (parse_index(a)?, Some(parse_index(b)?)),
+                    None => {
+                        let n = parse_index(range)?;
+                        (n, Some(n))
+                    }
+                },
+            };
+
+            let mut parts = strategy.trim().split('+');
+            let scheduler_name = parts.next().unwrap_or_default();
+            let scheduler = SCHEDULER_NAMES
+                .iter()
+                .find(|(name, _)| *name == scheduler_name)
+                .map(|(_, t)| *t)
+                .ok_or_else(|| format!("unknown scheduler `{scheduler_name}` in strategy plan"))?;
+
+            let mut mutator = MutatorType::Havoc;
+            for modifier in parts {
+                mutator = match modifier {
+                    "havoc" => MutatorType::Havoc,
+                    "mopt" => MutatorType::MOpt,
+                    other => return Err(format!("unknown mutator `{other}` in strategy plan")),
+                };
+            }
+
+            entries.push(Entry {
+                first,
+                last,
+                strategy: Strategy { scheduler, mutator },
+            });
+        }
+
+        Ok(Self { entries })
+    }
+
+    /// Strategy for the client with launcher index `client`.
+    pub fn strategy_for(&self, client: usize, fallback: Strategy) -> Strategy {
+        self.entries
+            .iter()
+            .find(|e| client >= e.first && e.last.is_none_or(|last| client <= last))
+            .map_or(fallback, |e| e.strategy)
+    }
+}
+
+fn parse_index(s: &str) -> Result<usize, String> {
+    s.trim()
+        .parse()
+        .map_err(|_| format!("invalid core index `{s}` in strategy plan"))
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const FALLBACK: Strategy = Strategy {
+        scheduler: SchedulerType::Queue,
+        mutator: MutatorType::Havoc,
+    };
+
+    fn strategy(scheduler: SchedulerType, mutator: MutatorType) -> Strategy {
+        Strategy { scheduler, mutator }
+    }
+
+    #[test]
+    fn empty_spec_uses_fallback() {
+        let plan = StrategyPlan::parse("").unwrap();
+        assert_eq!(plan.strategy_for(0, FALLBACK), FALLBACK);
+        let plan = StrategyPlan::parse(" , ").unwrap();
+        assert_eq!(plan.strategy_for(3, FALLBACK), FALLBACK);
+    }
+
+    #[test]
+    fn core_ranges() {
+        let plan = StrategyPlan::parse("0=explore, 1-3=queue+mopt, 5-=weighted").unwrap();
+        assert_eq!(
+            plan.strategy_for(0, FALLBACK),
+            strategy(SchedulerType::Explore, MutatorType::Havoc)
+        );
+        for client in 1..=3 {
+            assert_eq!(
+                plan.strategy_for(client, FALLBACK),
+                strategy(SchedulerType::Queue, MutatorType::MOpt)
+            );
+        }
+        assert_eq!(plan.strategy_for(4, FALLBACK), FALLBACK);
+        assert_eq!(
+            plan.strategy_for(63, FALLBACK),
+            strategy(SchedulerType::Weighted, MutatorType::Havoc)
+        );
+    }
+
+    #[test]
+    fn first_match_wins() {
+        let plan = StrategyPlan::parse("2=fast+mopt,*=minimized").unwrap();
+        assert_eq!(
+            plan.strategy_for(2, FALLBACK),
+            strategy(SchedulerType::Fast, MutatorType::MOpt)
+        );
+        assert_eq!(
+            plan.strategy_for(7, FALLBACK),
+            strategy(SchedulerType::Minimized, MutatorType::Havoc)
+        );
+    }
+
+    #[test]
+    fn invalid_specs() {
+        for spec in [
+            "explore",
+            "0=nope",
+            "0=queue+turbo",
+            "x=queue",
+            "1-y=queue",
+            "0=queue,1",
+        ] {
+            assert!(StrategyPlan::parse(spec).is_err(), "{spec}");
+        }
+    }
+
+    #[test]
+    fn display_round_trips() {
+        let s = strategy(SchedulerType::Coe, MutatorType::MOpt);
+        let plan = StrategyPlan::parse(&format!("0={s}")).unwrap();
+        assert_eq!(plan.strategy_for(0, FALLBACK), s);
+    }
+}
@@ -5,3 +5,21 @@ pub type CTargetFn = unsafe extern "C" fn(*const u8, usize);
 
 /// Target that receives a null-terminated C string.
 pub type CTargetStringFn = unsafe extern "C" fn(*const core::ffi::c_char);
+
+/// libFuzzer-compatible custom mutator (`LLVMFuzzerCustomMutator`): mutates
+/// `data[..size]` in place within a buffer of `max_size` bytes and returns the
+/// new size.
+pub type CCustomMutatorFn = unsafe extern "C" fn(*mut u8, usize, usize, u32) -> usize;
+
+/// libFuzzer-compatible custom crossover (`LLVMFuzzerCustomCrossOver`):
+/// combines two inputs into `out` (capacity `max_out_size`) and returns the
+/// size written.
+pub type CCustomCrossOverFn =
+    unsafe extern "C" fn(*const u8, usize, *const u8, usize, *mut u8, usize, u32) -> usize;
+
+/// Post-mutation fixup: repairs checksums or length fields of `data[..len]` in place.
+pub type CFixupFn = unsafe extern "C" fn(*mut u8, usize);
+
+/// Stats callback: receives an aggregate snapshot and the user's context pointer.
+pub type CStatsFn =
+    unsafe extern "C" fn(*const crate::config::PeelFuzzStats, *mut core::ffi::c_void);
@@ -0,0 +1,33 @@
+#!/usr/bin/env bash
+# Compare schedulers on bug1: seconds until each [BUG n] marker first appears.
+#
+# Usage: ./bench.sh [seconds-per-run] [scheduler...]
+#   ./bench.sh 600 queue weighted fast explore coe lin quad
+set -u
+
+DURATION=${1:-600}
+shift || true
+SCHEDULERS=${*:-queue weighted minimized fast explore exploit coe lin quad}
+
+printf "%-10s %8s %8s %8s\n" scheduler "BUG 1" "BUG 2" "BUG 3"
+
+for sched in $SCHEDULERS; do
+  rm -rf crashes hangs
+  declare -A found=()
+  start=$(date +%s)
+
+  while IFS= read -r line; do
+    case "$line" in
+      *"[BUG "[123]"]"*)
+        bug=${line#*\[BUG }
+        bug=${bug%%\]*}
+        [[ -z "${found[$bug]:-}" ]] && found[$bug]=$(( $(date +%s) - start ))
+        ;;
+    esac
+  done < <(timeout --signal=INT "$DURATION" ./bug1 "$sched" 2>/dev/null)
+
+  printf "%-10s %8s %8s %8s\n" "$sched" \
+    "${found[1]:--}" "${found[2]:--}" "${found[3]:--}"
+  unset found
+  pkill -f "./bug1 $sched" 2>/dev/null
+done
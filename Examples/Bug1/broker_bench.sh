@@ -0,0 +1,36 @@
+#!/usr/bin/env bash
+# Broker CPU under load: CPU seconds the broker spends per monitor interval.
+#
+# The broker runs in the launcher process and every core is a forked child,
+# so the launcher's own utime + stime is the broker's cost. bug1 keeps every
+# core busy with cheap runs, which is close to the worst case for event rate.
+#
+# Usage: ./broker_bench.sh [seconds-per-run] [monitor-interval...]
+#   ./broker_bench.sh 60 0 1 5     (0 = a status line per client event)
+set -u
+
+DURATION=${1:-60}
+shift || true
+INTERVALS=${*:-0 1 5}
+HZ=$(getconf CLK_TCK)
+
+printf "%-10s %10s %8s\n" interval "cpu sec" "cpu %"
+
+for interval in $INTERVALS; do
+  rm -rf crashes hangs
+  ./bug1 queue "$interval" >/dev/null 2>&1 &
+  pid=$!
+  sleep "$DURATION"
+
+  # Fields 14 and 15 of /proc/<pid>/stat: utime and stime, in clock ticks.
+  read -r -a stat < "/proc/$pid/stat"
+  ticks=$(( stat[13] + stat[14] ))
+
+  kill -INT "$pid" 2>/dev/null
+  wait "$pid" 2>/dev/null
+  pkill -f "./bug1 queue $interval" 2>/dev/null
+
+  printf "%-10s %10s %8s\n" "$interval" \
+    "$(awk -v t="$ticks" -v hz="$HZ" 'BEGIN { printf "%.2f", t / hz }')" \
+    "$(awk -v t="$ticks" -v hz="$HZ" -v d="$DURATION" 'BEGIN { printf "%.1f", 100 * t / hz / d }')"
+done
@@ -1,3 +1,4 @@
+#include <cstdlib>
 #include <cstring>
 #include <cstdint>
 #include <iostream>
@@ -181,7 +182,7 @@ void parse_packet(const uint8_t* data, size_t len) {
       return;
 
     std::cout << "[BUG 1] Ultra arithmetic maze solved — iteration "
-              << iterations << '\n';
+              << iterations << std::endl;
     int* bad = nullptr;
     *bad = 0xDEAD;
   }
@@ -256,7 +257,7 @@ void parse_packet(const uint8_t* data, size_t len) {
       return;
 
     std::cout << "[BUG 2] Deep command protocol breached — iteration "
-              << iterations << '\n';
+              << iterations << std::endl;
     char small[4];
     std::memcpy(small, payload + 12, payload_len - 12);  // buffer overflow
   }
@@ -336,7 +337,7 @@ void parse_packet(const uint8_t* data, size_t len) {
       return;
 
     std::cout << "[BUG 3] Multi-layer crypto breached — iteration "
-              << iterations << '\n';
+              << iterations << std::endl;
     int x = 1 / (int)(payload[8] - b8);  // division by zero
     (void)x;
   }
@@ -344,8 +345,58 @@ void parse_packet(const uint8_t* data, size_t len) {
   *x = 200;
 }
 
-int main() {
-  PeelFuzz peel(HARNESS_BYTES, (void*)parse_packet, SCHEDULER_QUEUE, 500, 20, 10);
+// Fixup hook: keeps gates 5-7 (length, CRC-16, XOR fold) satisfied so
+// mutations reach the version-specific logic
+static void fixup_packet(uint8_t* data, size_t len) {
+  if (len < sizeof(Header))
+    return;
+
+  Header hdr;
+  std::memcpy(&hdr, data, sizeof(Header));
+
+  const uint8_t* payload = data + sizeof(Header);
+  size_t payload_len = len - sizeof(Header);
+  hdr.length    = (uint16_t)payload_len;
+  hdr.crc       = crc16(payload, payload_len);
+  hdr.xor_check = xor_fold(payload, payload_len);
+
+  std::memcpy(data, &hdr, sizeof(Header));
+}
+
+// True if the environment variable is set to anything but "" or "0"
+static bool env_flag(const char* name) {
+  const char* value = std::getenv(name);
+  return value && *value && std::strcmp(value, "0") != 0;
+}
+
+// Optional argv[1] selects the scheduler by name (used by bench.sh) and
+// argv[2] the monitor interval in seconds (used by broker_bench.sh).
+// BUG1_FIXUP=1 enables the fixup hook and BUG1_CHECKSUM_REPAIR=1 automatic
+// checksum repair (build with `make cmp`); both are off by default so
+// scheduler benchmarks measure the fuzzer alone.
+static SchedulerType scheduler_from_name(const char* name) {
+  static const struct { const char* name; SchedulerType type; } table[] = {
+    {"queue",     SCHEDULER_QUEUE},     {"weighted", SCHEDULER_WEIGHTED},
+    {"minimized", SCHEDULER_MINIMIZED}, {"fast",     SCHEDULER_FAST},
+    {"explore",   SCHEDULER_EXPLORE},   {"exploit",  SCHEDULER_EXPLOIT},
+    {"coe",       SCHEDULER_COE},       {"lin",      SCHEDULER_LIN},
+    {"quad",      SCHEDULER_QUAD},
+  };
+  for (const auto& entry : table)
+    if (std::strcmp(name, entry.name) == 0)
+      return entry.type;
+  return SCHEDULER_QUEUE;
+}
+
+int main(int argc, char** argv) {
+  SchedulerType sched = argc > 1 ? scheduler_from_name(argv[1]) : SCHEDULER_QUEUE;
+  PeelFuzz peel(HARNESS_BYTES, (void*)parse_packet, sched, 500, 20, 10);
+  if (env_flag("BUG1_FIXUP"))
+    peel.setFixup(fixup_packet);
+  if (env_flag("BUG1_CHECKSUM_REPAIR"))
+    peel.setChecksumRepair(true);  // inner CRCs and hashes of V1-V3
+  if (argc > 2)
+    peel.setMonitorInterval(std::atoi(argv[2]));
 
   peel.runFuzzer(FuzzDuration::OneHr);
   